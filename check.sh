@@ -0,0 +1,116 @@
+#!/bin/sh
+# Self-check run by "make check": seeded runs of every engine and step mode,
+# each solution checked by the program's own validator. Prints one line per
+# check and exits non-zero if any of them failed. BIN picks the binary
+# (default ./nqueens_pgo_gen)
+
+BIN=${BIN:-./nqueens_pgo_gen}
+case $BIN in
+/*) ;;
+*) BIN=$PWD/$BIN ;;
+esac
+THREADS=4
+SEED=42
+failures=0
+tmp=$(mktemp -d) || exit 1
+trap 'rm -rf "$tmp"' EXIT
+
+# report STATUS NAME: record one check and print its line
+report() {
+    if [ "$1" -eq 0 ]; then
+        echo "ok    $2"
+    else
+        echo "FAIL  $2"
+        failures=$((failures + 1))
+    fi
+}
+
+# solves NAME OPTIONS...: three seeded runs of every size, all solved
+solves() {
+    name=$1
+    shift
+    "$BIN" -t $THREADS -r 3 -s $SEED "$@" >"$tmp/out" 2>&1
+    awk '/BOARDS SOLVED/ { seen = 1; if ($1 != $3) bad = 1 } END { exit !seen || bad }' "$tmp/out"
+    report $? "$name"
+}
+
+# prints NAME PATTERN OPTIONS...: one seeded run whose output has PATTERN
+prints() {
+    name=$1
+    pattern=$2
+    shift 2
+    "$BIN" -t $THREADS -r 1 -s $SEED "$@" >"$tmp/out" 2>&1
+    grep -q -- "$pattern" "$tmp/out"
+    report $? "$name"
+}
+
+solves "minconflicts" -n 1000,20000
+solves "minconflicts cross-checked" -n 500 -x
+solves "max-steps fraction" -n 1000 -m 2.5
+prints "max-steps too few" "Solution NOT found in 1 sets" -n 1000 -m 0.001
+
+# Every output format reads back as a valid solution
+for format in grid perm bin; do
+    rm -f "$tmp"/Solution_*
+    (cd "$tmp" && "$BIN" -t $THREADS -r 1 -s $SEED -n 300 -q -p $format && "$BIN" -c"$(ls Solution_*)") \
+        >"$tmp/out" 2>&1
+    grep -q '^Valid solution' "$tmp/out"
+    report $? "print $format"
+done
+
+solves "bulk" --mode bulk -n 1000,20000
+
+solves "async" --mode async -n 1000,20000
+
+solves "sample auto" --sample auto -n 20000
+solves "sample auto bulk" --sample auto --mode bulk -n 20000
+solves "sample auto async" --sample auto --mode async -n 20000
+
+solves "swap" --engine swap -n 100000
+
+solves "init perm" --init perm -n 20000
+solves "init greedy" --init greedy -n 100000
+solves "swap init greedy" --engine swap --init greedy -n 100000
+
+solves "construct" --engine construct -n 4,5,6,7,8,9,10,11,12,13,14,15,1000003
+solves "construct no symmetry" --engine construct --no-symmetry -n 1000002
+prints "construct n=2" "No solution exists" --engine construct -n 2
+prints "construct n=3" "No solution exists" --engine construct -n 3
+
+# The count engine against the known totals for n = 1..12 (OEIS A000170)
+n=1
+status=0
+for count in 1 0 0 2 10 4 40 92 352 724 2680 14200; do
+    "$BIN" -t $THREADS -r 1 --engine count -n $n >"$tmp/out" 2>&1
+    grep -q "COUNT: $count solutions" "$tmp/out" || status=1
+    n=$((n + 1))
+done
+report $status "count n=1..12"
+prints "count n=64" "limited to n <=" --engine count -n 64
+
+solves "portfolio 2" --portfolio 2 -n 20000
+
+solves "stall 2" --stall 2 -n 500
+solves "stall off" --stall 0 -n 20000
+
+prints "deadline" "Stopped after" --deadline 0.001 -n 1e6
+
+# A checkpointed solve stopped by its deadline resumes from the file, and
+# the solved file answers again straight away
+status=0
+"$BIN" -t $THREADS -r 1 -s $SEED -n 50000 --deadline 0.01 --checkpoint "$tmp/ckpt" >/dev/null 2>&1
+for run in resume reopen; do
+    "$BIN" -t $THREADS -r 1 -s 7 -n 50000 --checkpoint "$tmp/ckpt" >"$tmp/out" 2>&1
+    grep -q "Resumed from" "$tmp/out" && grep -q "1 OF 1 RANDOM" "$tmp/out" || status=1
+done
+report $status "checkpoint"
+
+printf '1000 3\n200 5 0 none\n50 9\n' | "$BIN" --serve -t $THREADS >"$tmp/out" 2>&1
+[ "$(awk '$2 == "solved"' "$tmp/out" | wc -l)" -eq 3 ]
+report $? "serve"
+
+solves "locality" --locality -n 20000
+solves "locality bulk" --locality --mode bulk -n 20000
+
+echo "$failures check(s) failed"
+[ "$failures" -eq 0 ]
@@ -1,509 +1,1134 @@
 #include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <time.h>
 #include <unistd.h>
 #include <stdatomic.h>
 #include <string.h>
+#include <limits.h>
+#include <getopt.h>
+#include <signal.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "nqueens.h"
+#include "nqueens_io.h"
+#include "nqueens_time.h"
+
+// Benchmark settings, all taken from the command line
+typedef struct {
+    int *sizes;
+    int numSizes;
+    int *threads;
+    int numThreads;
+    int reps;
+    int warmup;
+    double stepFactor;     // maxSteps = stepFactor * n, at least 1
+    uint64_t seed;
+    int printSolution;
+    OutputFormat outputFormat;
+    InitMethod init;
+    Engine engine;
+    int noSymmetry;
+    int splitDepth;
+    StepMode stepMode;
+    int sampleRows;
+    int sampleMisses;
+    int portfolio;         // Members racing per run, 1 for a plain solve
+    int stallWindow;
+    double deadline;       // Seconds per solve, 0 for none
+    int progressEvery;     // Steps between progress lines, 0 for none
+    const char *checkpoint;
+    double checkpointEvery;
+    int locality;
+    int crossCheck;
+    int quiet;
+    const char *csvPath;   // "-" for stdout
+    const char *jsonPath;
+#ifdef NQ_TELEMETRY
+    const char *tracePath;
+    FILE *trace;
+    int tracePerf;
+#endif
+} BenchOptions;
+
+// Spread of one metric over the solved runs of a configuration
+typedef struct {
+    double min;
+    double median;
+    double p95;
+    double max;
+} Stats;
 
-uint32_t random_state;
-
-// Board represents the N-Queens board
+// All runs of one (n, threads) configuration
 typedef struct {
     int n;
-    int *queens;
-    atomic_int *rowConflicts;
-    atomic_int *diag1Conflicts;
-    atomic_int *diag2Conflicts;
-} Board;
-
-// Function to compute absolute value
-int abs_int(int x) { return x < 0 ? -x : x; }
-
-// Function to find next random state
-uint32_t xorshift(){
-    random_state ^= random_state << 13;
-    random_state ^= random_state >> 17;
-    random_state ^= random_state << 5;
-    return random_state;
+    int threads;
+    int reps;
+    const char *init;
+    const char *engine;
+    const char *mode;
+    int portfolio;
+    SolveResult *runs;
+} BenchConfig;
+
+static int CompareDoubles(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
 }
 
+// Nearest-rank statistics of values[0, count)
+static Stats ComputeStats(double *values, int count) {
+    Stats st = {0, 0, 0, 0};
+    if (count == 0) {
+        return st;
+    }
+    qsort(values, count, sizeof(double), CompareDoubles);
+    st.min = values[0];
+    st.median = values[(count - 1) / 2];
+    int rank = (95 * count + 99) / 100;
+    st.p95 = values[rank - 1];
+    st.max = values[count - 1];
+    return st;
+}
 
-
-// Initialize the board with a random placement
-Board *NewBoard(int n) {
-
-    //Setup Variables
-    Board *board = (Board *)malloc(sizeof(Board));
-    board->n = n;
-    board->queens = (int *)malloc(n * sizeof(int));
-    board->rowConflicts = (atomic_int *)calloc(n, sizeof(atomic_int));
-    board->diag1Conflicts = (atomic_int *)calloc(2 * n, sizeof(atomic_int));
-    board->diag2Conflicts = (atomic_int *)calloc(2 * n, sizeof(atomic_int));
-    
-    //Atomicize Them
-    for (int i = 0; i < n; i++){
-        atomic_store(&board->rowConflicts[i],0);
+// Solve time and step statistics plus mean phase times over solved runs
+static int SummarizeConfig(const BenchConfig *c, Stats *time, Stats *steps, double phases[4]) {
+    double *t = (double *)malloc(c->reps * sizeof(double));
+    double *k = (double *)malloc(c->reps * sizeof(double));
+    int solved = 0;
+    phases[0] = phases[1] = phases[2] = phases[3] = 0;
+    for (int i = 0; i < c->reps; i++) {
+        const SolveResult *r = &c->runs[i];
+        if (r->status != SOLVE_SOLVED) {continue;}
+        t[solved] = r->initTime + r->loopTime;
+        k[solved] = r->steps;
+        phases[0] += r->initTime;
+        phases[1] += r->loopTime;
+        phases[2] += r->validateTime;
+        phases[3] += r->outputTime;
+        solved++;
     }
-    for (int i = 0; i < 2*n; i++){
-        atomic_store(&board->diag1Conflicts[i],0);
-        atomic_store(&board->diag2Conflicts[i],0);
+    for (int p = 0; p < 4 && solved; p++) {
+        phases[p] /= solved;
     }
+    *time = ComputeStats(t, solved);
+    *steps = ComputeStats(k, solved);
+    free(t);
+    free(k);
+    return solved;
+}
 
-    //Fill Queens With Initial Random State
-    for (int col = 0; col < n; col++) {
-        int row = xorshift() % board->n;
-        board->queens[col] = row;
-        board->rowConflicts[row]++;
-        board->diag1Conflicts[row - col + board->n]++;
-        board->diag2Conflicts[row + col]++;
+// Count engine: solutions of the first solved run, 0 for the search engines
+static uint64_t ConfigSolutions(const BenchConfig *c) {
+    for (int i = 0; i < c->reps; i++) {
+        if (c->runs[i].status == SOLVE_SOLVED) {return c->runs[i].solutions;}
     }
-    return board;
+    return 0;
 }
 
-// Deletes Board
-void DeleteBoard(Board *board){
-    if (board == NULL){return;}
-    free(board->queens);
-    free(board->rowConflicts);
-    free(board->diag1Conflicts);
-    free(board->diag2Conflicts);
-    free(board);
+// Count engine: nodes per second over all solved runs together
+static double ConfigNodeRate(const BenchConfig *c) {
+    double nodes = 0, seconds = 0;
+    for (int i = 0; i < c->reps; i++) {
+        const SolveResult *r = &c->runs[i];
+        if (r->status != SOLVE_SOLVED) {continue;}
+        nodes += r->nodes;
+        seconds += r->initTime + r->loopTime;
+    }
+    return seconds > 0 ? nodes / seconds : 0;
 }
 
-
-
-
-// Check If Queen At Given Column Has Any Conflicts
-int HasConflict(Board *b, int col) {
-
-    //Find The Row This Queen Is In
-    int row = b->queens[col];
-
-    //Determine If Conflict Exists
-    if (b->rowConflicts[row] > 1 || b->diag1Conflicts[row - col + b->n] > 1 ||
-        b->diag2Conflicts[row + col] > 1) {
-        return 1; // true
+// Open path for writing, "-" meaning stdout
+static FILE *OpenReport(const char *path) {
+    if (strcmp(path, "-") == 0) {
+        return stdout;
+    }
+    FILE *fp = fopen(path, "w");
+    if (fp == NULL) {
+        fprintf(stderr, "Error: Cannot open %s\n", path);
     }
-    return 0; // false
+    return fp;
 }
 
-// Update the queen's position in the board
-void UpdateQueen(Board *b, int col, int newRow) {
-    
-    //Find Old Row
-    int oldRow = b->queens[col];
-
-    //If No Movement, Return
-    if (oldRow == newRow) {
-        return;
+static void CloseReport(FILE *fp) {
+    if (fp != NULL && fp != stdout) {
+        fclose(fp);
     }
-
-    // Remove old conflicts
-    atomic_fetch_sub(&b->rowConflicts[oldRow], 1);
-    atomic_fetch_sub(&b->diag1Conflicts[oldRow - col + b->n],1);
-    atomic_fetch_sub(&b->diag2Conflicts[oldRow + col],1);
-
-    // Place queen at new position
-    b->queens[col] = newRow;
-
-    // Add new conflicts
-    atomic_fetch_add(&b->rowConflicts[newRow],1);
-    atomic_fetch_add(&b->diag1Conflicts[newRow - col + b->n],1);
-    atomic_fetch_add(&b->diag2Conflicts[newRow + col],1);
 }
 
-// Find Minimum Conflict Location for Queens in the given columns
-void MinimizeConflicts(Board *b, int *cols, int numCols) {
-
-    //Storing the Best Row Indexs
-    int *bestRows = (int *)malloc(b->n * sizeof(int));
-
-    //For every Row
-    for (int idx = 0; idx < numCols; idx++) {
-        int col = cols[idx];
-
-        //If No Conflicts - Do Nothing
-        if (!HasConflict(b, col)) {
-            continue;
-        }
+// One CSV row per configuration; times in seconds
+static void WriteBenchCSV(const char *path, BenchConfig *configs, int numConfigs) {
+    FILE *fp = OpenReport(path);
+    if (fp == NULL) {return;}
+    fprintf(fp, "n,threads,init,engine,mode,reps,solved,kernel,time_min,time_median,time_p95,time_max,"
+                "steps_min,steps_median,steps_p95,steps_max,init_mean,loop_mean,validate_mean,output_mean,solutions,nodes_per_sec,portfolio\n");
+    for (int i = 0; i < numConfigs; i++) {
+        Stats time, steps;
+        double phases[4];
+        int solved = SummarizeConfig(&configs[i], &time, &steps, phases);
+        fprintf(fp, "%d,%d,%s,%s,%s,%d,%d,%s,%.9f,%.9f,%.9f,%.9f,%.0f,%.0f,%.0f,%.0f,%.9f,%.9f,%.9f,%.9f,%llu,%.0f,%d\n",
+                configs[i].n, configs[i].threads, configs[i].init, configs[i].engine, configs[i].mode, configs[i].reps, solved, RowScanKernel(),
+                time.min, time.median, time.p95, time.max,
+                steps.min, steps.median, steps.p95, steps.max,
+                phases[0], phases[1], phases[2], phases[3],
+                (unsigned long long)ConfigSolutions(&configs[i]), ConfigNodeRate(&configs[i]), configs[i].portfolio);
+    }
+    CloseReport(fp);
+}
 
-        
-        int numBestRows = 0;
-        int minConflicts = b->n; // Maximum possible conflicts per queen
-        int diag1 = -col + b->n;
-
-
-        // Find all rows with the minimum number of conflicts
-        for (int row = 0; row < b->n; row++) {
-            int conflicts = b->rowConflicts[row] + \
-                            b->diag1Conflicts[row + diag1] + \
-                            b->diag2Conflicts[row + col];
-            //New Best - Replace
-            if (conflicts < minConflicts) {
-                bestRows[0] = row;
-                numBestRows = 1;
-                minConflicts = conflicts;
-            //Tied Best - Add To List
-            } else if (conflicts == minConflicts) {
-                bestRows[numBestRows++] = row;
-            }
+// Configurations with their statistics and every individual run
+static void WriteBenchJSON(const char *path, BenchConfig *configs, int numConfigs, uint64_t seed) {
+    FILE *fp = OpenReport(path);
+    if (fp == NULL) {return;}
+    fprintf(fp, "{\n  \"kernel\": \"%s\",\n  \"seed\": %llu,\n  \"results\": [", RowScanKernel(),
+            (unsigned long long)seed);
+    for (int i = 0; i < numConfigs; i++) {
+        BenchConfig *c = &configs[i];
+        Stats time, steps;
+        double phases[4];
+        int solved = SummarizeConfig(c, &time, &steps, phases);
+        fprintf(fp, "%s\n    {\"n\": %d, \"threads\": %d, \"init\": \"%s\", \"engine\": \"%s\", \"mode\": \"%s\",\n"
+                    "     \"reps\": %d, \"solved\": %d,\n",
+                i ? "," : "", c->n, c->threads, c->init, c->engine, c->mode, c->reps, solved);
+        fprintf(fp, "     \"time\": {\"min\": %.9f, \"median\": %.9f, \"p95\": %.9f, \"max\": %.9f},\n",
+                time.min, time.median, time.p95, time.max);
+        fprintf(fp, "     \"steps\": {\"min\": %.0f, \"median\": %.0f, \"p95\": %.0f, \"max\": %.0f},\n",
+                steps.min, steps.median, steps.p95, steps.max);
+        fprintf(fp, "     \"phases\": {\"init\": %.9f, \"loop\": %.9f, \"validate\": %.9f, \"output\": %.9f},\n",
+                phases[0], phases[1], phases[2], phases[3]);
+        fprintf(fp, "     \"solutions\": %llu, \"nodes_per_sec\": %.0f, \"portfolio\": %d,\n",
+                (unsigned long long)ConfigSolutions(c), ConfigNodeRate(c), c->portfolio);
+        fprintf(fp, "     \"runs\": [");
+        for (int r = 0; r < c->reps; r++) {
+            SolveResult *run = &c->runs[r];
+            fprintf(fp, "%s\n       {\"seed\": %llu, \"solved\": %d, \"steps\": %ld, \"init\": %.9f, "
+                        "\"loop\": %.9f, \"validate\": %.9f, \"output\": %.9f, \"nodes\": %llu, \"member\": %d, "
+                        "\"perturbations\": %d, \"restarts\": %d, \"conflicts\": %d, \"stopped\": %d, \"resumed\": %d}",
+                    r ? "," : "", (unsigned long long)run->seed, run->status == SOLVE_SOLVED, run->steps,
+                    run->initTime, run->loopTime, run->validateTime, run->outputTime,
+                    (unsigned long long)run->nodes, run->member, run->perturbations, run->restarts,
+                    run->conflicts, run->status == SOLVE_STOPPED, run->resumed);
         }
-
-        // Randomly select one of the best rows to diversify moves
-        int newRow = bestRows[xorshift() % numBestRows];
-
-        UpdateQueen(b, col, newRow);
+        fprintf(fp, "]}");
     }
-    free(bestRows);
+    fprintf(fp, "\n  ]\n}\n");
+    CloseReport(fp);
 }
 
-
-// Validate if the solution is valid (no queens attack each other)
-int ValidateSolution(int *queens, int n) {
-    for (int i = 0; i < n; i++) {
-        //Check Values Within Range
-        if ((queens[i] > n) || (queens[i] < 0)){
-            return 0;
-        }
-        for (int j = i + 1; j < n; j++) {
-            // Check row conflicts
-            if (queens[i] == queens[j]) {
-                return 0; // false
-            }
-            // Check diagonal conflicts
-            if (abs_int(i - j) == abs_int(queens[i] - queens[j])) {
-                return 0; // false
-            }
+// Parse "100,1e4,20000" into a fresh array, returning its length or -1
+static int ParseIntList(const char *text, int **out) {
+    int count = 1;
+    for (const char *c = text; *c; c++) {
+        if (*c == ',') {count++;}
+    }
+    int *values = (int *)malloc(count * sizeof(int));
+    const char *p = text;
+    for (int i = 0; i < count; i++) {
+        char *end;
+        double v = strtod(p, &end);
+        if (end == p || v < 1 || v > INT_MAX || (*end != ',' && *end != '\0')) {
+            free(values);
+            return -1;
         }
+        values[i] = (int)v;
+        p = end + 1;
     }
-    return 1; // true
+    free(*out);
+    *out = values;
+    return count;
 }
 
-// Structure to pass data to threads
-typedef struct {
-    Board *board;
-    int *cols;
-    int numCols;
-} ThreadData;
-
-// Thread function to minimize conflicts
-void *MinimizeConflictsThread(void *arg) {
-    ThreadData *data = (ThreadData *)arg;
-    MinimizeConflicts(data->board, data->cols, data->numCols);
-    return NULL;
+// Service mode: one request per line, "n [seed [deadline [format]]]", each
+// answered by one line "id status steps seconds [rows...]" in the order the
+// solves finish. id counts the stream's lines from 0; seed 0 or none draws
+// one from the master seed, deadline 0 or none keeps --deadline, format is
+// perm (the rows, default) or none. Small boards run one per lane, one
+// lane per thread; boards from fanout queens up wait for every lane to go
+// idle and run on all threads
+#define SERVE_QUEUE 1024
+#define SERVE_FANOUT_MIN_N 16384
+
+static void PrintUsage(const char *prog) {
+    printf("Usage: %s [options]\n"
+           "With no options, validates input.txt as before.\n\n"
+           "  -c, --check[=FILE]       validate FILE (default input.txt) and exit\n"
+           "  -n, --sizes LIST         board sizes to solve, e.g. 100,1000,1e5 (default 100)\n"
+           "  -r, --reps N             measured runs per size and thread count (default 5,\n"
+           "                           1 with --checkpoint)\n"
+           "  -t, --threads LIST       worker counts to benchmark (default: online CPUs)\n"
+           "  -w, --warmup N           unmeasured runs before each configuration (default 0)\n"
+           "  -s, --seed N             master seed (default: current time)\n"
+           "  -m, --max-steps F        give up after F*n steps, F may be fractional (default 10)\n"
+           "      --init METHOD        random (default), perm or greedy starting placement\n"
+           "      --engine ENGINE      minconflicts (default); swap: single-threaded\n"
+           "                           permutation swap search, steps are swaps;\n"
+           "                           construct: closed-form solution, no search;\n"
+           "                           count: exact number of solutions, n <= 63\n"
+           "      --no-symmetry        construct: skip the random board symmetry\n"
+           "      --split-depth D      count: rows fixed per parallel task (default auto)\n"
+           "      --mode MODE          atomic (default): counters updated per move\n"
+           "                           bulk: counter changes merged once per step\n"
+           "                           async: no steps, work-stealing deques of columns\n"
+           "      --sample K|auto      try K random rows for a free one before each full scan,\n"
+           "                           auto: %d rows from n = %d up\n"
+           "      --sample-misses F    after F misses in a row sample one move in F (default 8)\n"
+           "      --stall W            perturb the board after W steps without a new fewest\n"
+           "                           conflicts, restart after %d stalls; 0 never (default 64)\n"
+           "      --deadline S         stop each solve after S seconds, keeping its best board\n"
+           "      --progress K         print the conflict count every K steps to stderr\n"
+           "      --checkpoint FILE    keep the board in FILE, flushed at step boundaries, and\n"
+           "                           resume from it when it holds a board of the same size\n"
+           "      --checkpoint-every S seconds between flushes (default 60)\n"
+           "      --portfolio K        race K boards with their own seeds, splitting the\n"
+           "                           threads between them; the first to solve wins\n"
+           "      --locality           pin each thread to a CPU and keep its block of columns,\n"
+           "                           and their memory, with it\n"
+           "      --serve[=SOCKET]     answer requests \"n [seed [deadline [perm|none]]]\", one per\n"
+           "                           line, from stdin or a Unix socket; small boards run one\n"
+           "                           per thread, large ones on all threads\n"
+           "      --fanout N           serve: smallest n solved on all threads (default %d)\n"
+           "  -p, --print FORMAT       write solutions as grid, perm or bin\n"
+           "  -x, --cross-check        also run the O(n^2) validator\n"
+           "  -q, --quiet              no per-run lines\n"
+           "      --csv FILE           summary CSV (\"-\" for stdout)\n"
+           "      --json FILE          summary and per-run JSON (\"-\" for stdout)\n"
+           "  -h, --help               this text\n", prog, SAMPLE_AUTO_ROWS, SAMPLE_AUTO_MIN_N, STALL_RESTART,
+           SERVE_FANOUT_MIN_N);
+#ifdef NQ_TELEMETRY
+    printf("\nTelemetry build:\n"
+           "      --trace FILE         per-step CSV trace of the min-conflicts loop\n"
+           "      --perf               add cycles, LLC and branch misses to the trace\n");
+#endif
 }
 
-//Prints Solution Board Into Named .txt file
-void PrintSolutionToFile(int *queens, int n, int run, int total){
-    char filename[100];
-    sprintf(filename, "Solution_%d_%dof%d.txt",n,run,total);
-    
-    FILE *fp = fopen(filename, "w");
-
-    for (int row = 0; row < n; row++){
-        for (int col = 0; col < n; col++){
-            if (queens[col] == row){
-                fprintf(fp, "Q ");
-            } else {
-                fprintf(fp, ". ");
-            }
-        }
-        fprintf(fp, "\n");
-    }
-    fclose(fp);
-}
+// Raised by Ctrl-C or SIGTERM: the running solve stops and no further runs
+// start. A second signal kills the program as usual
+static atomic_int interrupted;
 
+static void OnInterrupt(int sig) {
+    atomic_store(&interrupted, 1);
+    signal(sig, SIG_DFL);
+}
 
-// File input function that validates input.txt as a solution for nQueens, and
-// validates it Required function for assignment submission
-void file_input() {
-  FILE *fp = fopen("input.txt", "r");
-  if (fp == NULL) {
-    printf("Error: Cannot open input.txt\n");
-    return;
-  }
+// Block or unblock SIGINT and SIGTERM on the calling thread. Threads start
+// with their creator's mask, so the service creates its lanes, solvers and
+// readers with them blocked: a signal then always lands on the main thread
+// and breaks it out of getline or accept
+static void BlockInterrupts(int block) {
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGINT);
+    sigaddset(&set, SIGTERM);
+    pthread_sigmask(block ? SIG_BLOCK : SIG_UNBLOCK, &set, NULL);
+}
 
-  int n = 0;
-  int *queens = NULL;
-  char line[1024]; // Assuming max board size is less than 1024
+// Progress callback of the command line: one line on stderr
+static void PrintProgress(void *arg, int step, int numConflicts, double elapsed) {
+    (void)arg;
+    fprintf(stderr, "    step %d: %d conflicted queens after %.3f s\n", step, numConflicts, elapsed);
+}
 
-  int row = 0;
-  int board_size = -1; // Initialize to invalid value
+// Step limit of an n-queens solve: stepFactor * n, at least 1
+static int MaxSteps(const BenchOptions *opt, int n) {
+    double steps = opt->stepFactor * n;
+    return steps < 1 ? 1 : steps < INT_MAX ? (int)steps : INT_MAX;
+}
 
-  while (fgets(line, sizeof(line), fp)) {
-    // Remove newline character at the end, if any
-    size_t len = strlen(line);
-    if (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) {
-      line[--len] = '\0';
-    }
+// Solver settings from the command line
+static SolverOptions SolverOptionsFor(const BenchOptions *opt) {
+    SolverOptions so = DefaultSolverOptions();
+    so.init = opt->init;
+    so.engine = opt->engine;
+    so.constructSymmetry = !opt->noSymmetry;
+    so.splitDepth = opt->splitDepth;
+    so.stepMode = opt->stepMode;
+    so.sampleRows = opt->sampleRows;
+    so.sampleMisses = opt->sampleMisses;
+    so.stallWindow = opt->stallWindow;
+    so.portfolio = opt->portfolio;
+    so.deadline = opt->deadline;
+    so.stop = &interrupted;
+    so.progress = PrintProgress;
+    so.progressEvery = opt->progressEvery;
+    so.checkpoint = opt->checkpoint;
+    so.checkpointEvery = opt->checkpointEvery;
+    so.locality = opt->locality;
+#ifdef NQ_TELEMETRY
+    so.trace = opt->trace;
+    so.tracePerf = opt->tracePerf;
+#endif
+    so.crossCheck = opt->crossCheck;
+    return so;
+}
 
-    // Ignore empty lines
-    if (len == 0) {
-      continue;
+// Per-run lines for one result of s on n
+static void PrintRun(const BenchOptions *opt, const Solver *s, const SolveResult *r, int n) {
+    double total = r->initTime + r->loopTime;
+    const char *workName = opt->engine == ENGINE_SWAP ? "swaps" : "column visits";
+    int stepless = opt->engine == ENGINE_SWAP || opt->stepMode == STEP_ASYNC;
+
+    //A Portfolio Only Reports Its Winner
+    if (SolverMembers(s) > 1) {
+        if (r->status == SOLVE_SOLVED) {
+            printf(" -- Member %d of %d won in %.3f seconds, %ld steps (seed %llu)\n", r->member, SolverMembers(s),
+                   total, r->steps, (unsigned long long)r->seed);
+        } else {
+            printf(" -- ERROR No member of %d found a solution\n", SolverMembers(s));
+        }
+        return;
     }
 
-    // Split the line into tokens
-    char *tokens[1024];
-    int token_count = 0;
-    char *token = strtok(line, " \t");
-    while (token != NULL) {
-      tokens[token_count++] = token;
-      token = strtok(NULL, " \t");
+    if (r->resumed) {
+        printf(" -- Resumed from %s (seed %llu)\n", opt->checkpoint, (unsigned long long)r->seed);
     }
-
-    if (board_size == -1) {
-      // First non-empty line, determine board size
-      board_size = token_count;
-      n = board_size;
-      if (n <= 0) {
-        printf("Error: Invalid board size\n");
-        fclose(fp);
+    switch (r->status) {
+    case SOLVE_UNSUPPORTED:
+        printf(" -- ERROR Counting is limited to n <= %d\n", COUNT_MAX_N);
         return;
-      }
-      // Allocate queens array
-      queens = (int *)malloc(n * sizeof(int));
-      if (queens == NULL) {
-        printf("Error: Memory allocation failed\n");
-        fclose(fp);
+    case SOLVE_NO_SOLUTION:
+        printf(" -- ERROR No solution exists for n = %d\n", n);
         return;
-      }
-      // Initialize queens array to -1
-      for (int i = 0; i < n; i++) {
-        queens[i] = -1;
-      }
-    } else {
-      if (token_count != board_size) {
-        printf("Error: Inconsistent line length at row %d\n", row);
-        free(queens);
-        fclose(fp);
+    case SOLVE_CHECKPOINT_FAILED:
+        printf(" -- ERROR Cannot use checkpoint file %s\n", opt->checkpoint);
         return;
-      }
-    }
-
-    // Process the tokens
-    int numQ = 0; // Number of 'Q's in this row
-    for (int col = 0; col < n; col++) {
-      char *c = tokens[col];
-      if (strlen(c) != 1) {
-        printf("Error: Invalid character '%s' at row %d, column %d\n", c, row,
-               col);
-        free(queens);
-        fclose(fp);
+    case SOLVE_NO_MEMORY:
+        printf(" -- ERROR Out of memory for n = %d\n", n);
         return;
-      }
-      if (c[0] == 'Q') {
-        numQ++;
-        if (numQ > 1) {
-          printf("Error: More than one queen in row %d\n", row);
-          free(queens);
-          fclose(fp);
-          return;
+    case SOLVE_STOPPED:
+        printf(" -- Stopped after %.3f seconds with %d conflicted queens\n", total, r->conflicts);
+        break;
+    case SOLVE_NOT_FOUND:
+        if (stepless) {
+            printf(" -- ERROR Solution NOT found in %ld %s\n", r->steps, workName);
+        } else {
+            printf(" -- ERROR Solution NOT found in %ld sets of steps (%d perturbations, %d restarts)\n",
+                   r->steps, r->perturbations, r->restarts);
         }
-        if (queens[col] != -1) {
-          printf("Error: More than one queen in column %d\n", col);
-          free(queens);
-          fclose(fp);
-          return;
+        break;
+    case SOLVE_SOLVED:
+    case SOLVE_INVALID:
+        if (opt->engine == ENGINE_COUNT) {
+            printf(" -- %llu solutions, %llu nodes from %ld tasks in %.3f seconds (%.3g nodes/s)\n",
+                   (unsigned long long)r->solutions, (unsigned long long)r->nodes, r->steps,
+                   total, total > 0 ? r->nodes / total : 0);
+            return;
         }
-        queens[col] = row;
-      } else if (c[0] != '.') {
-        printf("Error: Invalid character '%c' at row %d, column %d\n", c[0],
-               row, col);
-        free(queens);
-        fclose(fp);
-        return;
-      }
+        printf(" -- Solution found in %.3f seconds \n", total);
+        if (opt->engine == ENGINE_CONSTRUCT) {
+            printf(" -- Solution constructed directly \n");
+        } else if (stepless) {
+            printf(" -- Solution found in %ld %s \n", r->steps, workName);
+        } else {
+            printf(" -- Solution found in %ld (%ld) sets of steps \n", r->steps, r->steps * SolverThreads(s));
+        }
+        if (r->perturbations) {
+            printf(" -- After %d perturbations and %d restarts \n", r->perturbations, r->restarts);
+        }
+        break;
     }
-
-    if (numQ == 0) {
-      printf("Error: No queen found in row %d\n", row);
-      free(queens);
-      fclose(fp);
-      return;
+#ifdef NQ_TELEMETRY
+    const SolveTelemetry *t = &r->telemetry;
+    if (opt->engine == ENGINE_MIN_CONFLICTS) {
+        double capacity = t->parallel * t->workers;
+        printf(" -- Telemetry: %ld moves, %ld no-ops, %.1f best rows per scan, serial %.3f s, parallel %.3f s, "
+               "workers busy %.0f%% \n", t->moves, t->noops, t->scans ? (double)t->ties / t->scans : 0,
+               t->serial, t->parallel, capacity > 0 ? 100 * t->busy / capacity : 0);
     }
+#endif
+    if (r->status == SOLVE_SOLVED) {
+        printf(" -- Solution is valid!\n\n");
+    } else if (r->status == SOLVE_INVALID) {
+        printf(" -- ERROR: Invalid solution found\n");
+    }
+}
 
-    row++;
-  }
+// One client stream, freed with its last answer
+typedef struct ServeConn {
+    int fd;                 // Answers go here; closed at the end unless stdout
+    pthread_mutex_t mu;     // One answer written at a time
+    atomic_int refs;        // The reader plus every unanswered request
+    struct ServeConn *next; // Streams still being read, for shutdown
+} ServeConn;
 
-  if (row != n) {
-    printf("Error: Expected %d rows, but got %d rows\n", n, row);
-    free(queens);
-    fclose(fp);
-    return;
-  }
+typedef struct {
+    ServeConn *conn;
+    long id;
+    int n;
+    uint64_t seed;
+    double deadline;        // 0 for the --deadline of the service
+    int perm;               // Answer with the rows
+} ServeRequest;
 
-  fclose(fp);
+// Requests waiting for a lane, and the lanes' coordination
+typedef struct {
+    const BenchOptions *opt;
+    int numLanes;
+    int fanout;             // Smallest n solved on every thread
+    ServeRequest queue[SERVE_QUEUE];
+    int head;
+    int count;
+    int closed;             // No more requests; lanes drain the queue and leave
+    int busy;               // Lanes inside a one-thread solve
+    int wide;               // A fanned-out solve waits for the lanes or runs
+    Solver *wideSolver;
+    uint64_t master;        // Seeds for requests without one
+    ServeConn *readers;
+    int numReaders;
+    pthread_mutex_t mu;
+    pthread_cond_t changed;
+} ServeQueue;
+
+static const char *const SolveStatusNames[] = {
+    "solved", "notfound", "stopped", "invalid", "nosolution", "unsupported", "checkpointfailed", "nomemory"
+};
+
+static ServeConn *NewServeConn(int fd) {
+    ServeConn *c = (ServeConn *)calloc(1, sizeof(ServeConn));
+    c->fd = fd;
+    pthread_mutex_init(&c->mu, NULL);
+    atomic_store(&c->refs, 1);
+    return c;
+}
 
-  // Now check if all columns have a queen
-  for (int col = 0; col < n; col++) {
-    if (queens[col] == -1) {
-      printf("Error: No queen found in column %d\n", col);
-      free(queens);
-      return;
+static void ReleaseServeConn(ServeConn *c) {
+    if (atomic_fetch_sub(&c->refs, 1) != 1) {
+        return;
+    }
+    if (c->fd != STDOUT_FILENO) {
+        close(c->fd);
     }
-  }
+    pthread_mutex_destroy(&c->mu);
+    free(c);
+}
 
-  // Now we have queens[col] = row for each column.
-  // Now validate the solution
-  if (ValidateSolution(queens, n)) {
-    printf("Valid solution\n");
-  } else {
-    printf("Invalid solution\n");
-  }
+// Write one answer line in a single write and drop the request's reference
+static void ServeAnswer(ServeConn *c, long id, const SolveResult *r, const int *queens, int n) {
+    size_t size = 128 + (queens ? (size_t)n * 11 : 0);
+    char *line = (char *)malloc(size);
+    int len = snprintf(line, size, "%ld %s %ld %.6f", id, r ? SolveStatusNames[r->status] : "error",
+                       r ? r->steps : 0, r ? r->initTime + r->loopTime : 0);
+    if (r && r->status == SOLVE_SOLVED && r->solutions) {
+        len += snprintf(line + len, size - len, " %llu", (unsigned long long)r->solutions);
+    }
+    for (int col = 0; queens && col < n; col++) {
+        len += snprintf(line + len, size - len, " %d", queens[col]);
+    }
+    line[len++] = '\n';
+    pthread_mutex_lock(&c->mu);
+    WriteAll(c->fd, line, len);
+    pthread_mutex_unlock(&c->mu);
+    free(line);
+    ReleaseServeConn(c);
+}
 
-  free(queens);
+// Parse one request line into r; 0 if it is malformed
+static int ParseServeRequest(const char *line, ServeRequest *r) {
+    char format[16] = "perm";
+    unsigned long long seed = 0;
+    double n = 0;
+    r->deadline = 0;
+    int fields = sscanf(line, "%lf %llu %lf %15s", &n, &seed, &r->deadline, format);
+    if (fields < 1 || n < 1 || n > INT_MAX || r->deadline < 0) {
+        return 0;
+    }
+    if (strcmp(format, "perm") != 0 && strcmp(format, "none") != 0) {
+        return 0;
+    }
+    r->n = (int)n;
+    r->seed = seed;
+    r->perm = strcmp(format, "perm") == 0;
+    return 1;
 }
 
+// Queue a request, waiting while the queue is full. 0 once it is closed
+static int PushServeRequest(ServeQueue *q, ServeRequest *r) {
+    pthread_mutex_lock(&q->mu);
+    while (q->count == SERVE_QUEUE && !q->closed) {
+        pthread_cond_wait(&q->changed, &q->mu);
+    }
+    if (q->closed) {
+        pthread_mutex_unlock(&q->mu);
+        return 0;
+    }
+    if (r->seed == 0) {
+        r->seed = NextSeed(&q->master);
+    }
+    q->queue[(q->head + q->count) % SERVE_QUEUE] = *r;
+    q->count++;
+    pthread_cond_broadcast(&q->changed);
+    pthread_mutex_unlock(&q->mu);
+    return 1;
+}
 
+// Read requests from in until it ends, answering on c
+static void ServeStream(ServeQueue *q, FILE *in, ServeConn *c) {
+    char *line = NULL;
+    size_t capacity = 0;
+    long id = 0;
+    while (!atomic_load(&interrupted) && getline(&line, &capacity, in) >= 0) {
+        ServeRequest r;
+        r.conn = c;
+        r.id = id++;
+        atomic_fetch_add(&c->refs, 1);
+        if (!ParseServeRequest(line, &r)) {
+            ServeAnswer(c, r.id, NULL, NULL, 0);
+        } else if (!PushServeRequest(q, &r)) {
+            ReleaseServeConn(c);
+            break;
+        }
+    }
+    free(line);
+}
 
+// One lane: solve small requests on its own one-thread solver, and run a
+// large one on the wide solver once every other lane is idle
+static void *ServeLane(void *arg) {
+    ServeQueue *q = (ServeQueue *)arg;
+    SolverOptions so = SolverOptionsFor(q->opt);
+    Solver *own = NewSolver(1, &so);
+    pthread_mutex_lock(&q->mu);
+    for (;;) {
+        while ((q->count == 0 && !q->closed) || q->wide) {
+            pthread_cond_wait(&q->changed, &q->mu);
+        }
+        if (q->count == 0) {
+            break;
+        }
+        ServeRequest r = q->queue[q->head];
+        q->head = (q->head + 1) % SERVE_QUEUE;
+        q->count--;
+        Solver *s = own;
+        if (own == NULL) {
+            pthread_mutex_unlock(&q->mu);
+            ServeAnswer(r.conn, r.id, NULL, NULL, 0);
+            pthread_mutex_lock(&q->mu);
+            continue;
+        }
+        if (r.n >= q->fanout && q->numLanes > 1) {
+            q->wide = 1;
+            while (q->busy > 0) {
+                pthread_cond_wait(&q->changed, &q->mu);
+            }
+            s = q->wideSolver;
+        } else {
+            q->busy++;
+        }
+        pthread_cond_broadcast(&q->changed);
+        pthread_mutex_unlock(&q->mu);
+
+        int maxSteps = MaxSteps(q->opt, r.n);
+        SolverSetDeadline(s, r.deadline > 0 ? r.deadline : q->opt->deadline);
+        SolveResult result = Solve(s, r.n, maxSteps, r.seed);
+        const int *queens = r.perm && result.status == SOLVE_SOLVED ? SolverQueens(s) : NULL;
+        ServeAnswer(r.conn, r.id, &result, queens, r.n);
+
+        pthread_mutex_lock(&q->mu);
+        if (s == own) {
+            q->busy--;
+        } else {
+            q->wide = 0;
+        }
+        pthread_cond_broadcast(&q->changed);
+    }
+    pthread_mutex_unlock(&q->mu);
+    DeleteSolver(own);
+    return NULL;
+}
 
+// Reader thread of one socket connection
+typedef struct {
+    ServeQueue *q;
+    ServeConn *c;
+} ServeReaderArgs;
+
+static void *ServeReader(void *arg) {
+    ServeReaderArgs a = *(ServeReaderArgs *)arg;
+    free(arg);
+    FILE *in = fdopen(dup(a.c->fd), "r");
+    if (in != NULL) {
+        ServeStream(a.q, in, a.c);
+        fclose(in);
+    }
 
-// Solve the N-Queens problem using an optimized parallel Min-Conflicts
-// algorithm
-double SolveParallel(int n, int maxSteps, int numCPU, int run_num, int run_total, int printSolution) {
+    //Leave The Reader List, Then Let The Last Answer Close The Stream
+    pthread_mutex_lock(&a.q->mu);
+    ServeConn **p = &a.q->readers;
+    while (*p != a.c) {
+        p = &(*p)->next;
+    }
+    *p = a.c->next;
+    a.q->numReaders--;
+    pthread_cond_broadcast(&a.q->changed);
+    pthread_mutex_unlock(&a.q->mu);
+    ReleaseServeConn(a.c);
+    return NULL;
+}
 
-    //Store REAL time counts
-    struct timespec start, end;
-    clock_gettime(CLOCK_MONOTONIC, &start);
+// Accept connections on a Unix socket at path until interrupted, one reader
+// thread each. Returns 0 if the socket cannot be set up
+static int ServeSocket(ServeQueue *q, const char *path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Error: Socket path too long: %s\n", path);
+        return 0;
+    }
+    strcpy(addr.sun_path, path);
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(path);
+    if (listener < 0 || bind(listener, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(listener, 64) != 0) {
+        fprintf(stderr, "Error: Cannot listen on %s: %s\n", path, strerror(errno));
+        if (listener >= 0) {close(listener);}
+        return 0;
+    }
+    int ok = 1;
+    while (!atomic_load(&interrupted)) {
+        int fd = accept(listener, NULL, NULL);
+        if (fd < 0 && (errno == EINTR || errno == ECONNABORTED)) {
+            continue;
+        }
 
-    //Create Board
-    Board *board = NewBoard(n);
+        //Out Of Descriptors: Wait For A Reader To Leave (Or A Second) Instead Of Spinning
+        if (fd < 0 && (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM)) {
+            fprintf(stderr, "Warning: accept on %s: %s, waiting\n", path, strerror(errno));
+            struct timespec until;
+            clock_gettime(CLOCK_REALTIME, &until);
+            until.tv_sec += 1;
+            pthread_mutex_lock(&q->mu);
+            pthread_cond_timedwait(&q->changed, &q->mu, &until);
+            pthread_mutex_unlock(&q->mu);
+            continue;
+        }
+        if (fd < 0) {
+            fprintf(stderr, "Error: accept on %s: %s\n", path, strerror(errno));
+            ok = 0;
+            break;
+        }
+        ServeReaderArgs *a = (ServeReaderArgs *)malloc(sizeof(ServeReaderArgs));
+        a->q = q;
+        a->c = NewServeConn(fd);
+        pthread_mutex_lock(&q->mu);
+        a->c->next = q->readers;
+        q->readers = a->c;
+        q->numReaders++;
+        pthread_mutex_unlock(&q->mu);
+        pthread_t thread;
+        BlockInterrupts(1);
+        pthread_create(&thread, NULL, ServeReader, a);
+        BlockInterrupts(0);
+        pthread_detach(thread);
+    }
+    close(listener);
+    unlink(path);
 
-    //Setup Memory And Threads
-    int step = 0;
-    int *conflictCols = (int *)malloc(n * sizeof(int));
-    pthread_t *threadPool = (pthread_t *)malloc(numCPU*sizeof(pthread_t));
-    ThreadData *threadDataPool = (ThreadData *)malloc(numCPU*sizeof(ThreadData));
+    //Wake The Readers Still Blocked On Their Connections And Wait For Them
+    pthread_mutex_lock(&q->mu);
+    for (ServeConn *c = q->readers; c != NULL; c = c->next) {
+        shutdown(c->fd, SHUT_RD);
+    }
+    while (q->numReaders > 0) {
+        pthread_cond_wait(&q->changed, &q->mu);
+    }
+    pthread_mutex_unlock(&q->mu);
+    return ok;
+}
 
+// Run the service on stdin/stdout, or on a Unix socket if path is set
+static int Serve(const BenchOptions *opt, const char *path, int fanout) {
+    ServeQueue *q = (ServeQueue *)calloc(1, sizeof(ServeQueue));
+    q->opt = opt;
+    q->numLanes = opt->threads[0];
+    q->fanout = fanout;
+    q->master = opt->seed;
+    pthread_mutex_init(&q->mu, NULL);
+    pthread_cond_init(&q->changed, NULL);
+
+    //Only The Main Thread Takes Signals, So They Interrupt Its Blocking Reads And
+    //Accepts Instead Of Restarting Them
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = OnInterrupt;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+    BlockInterrupts(1);
+    SolverOptions so = SolverOptionsFor(opt);
+    q->wideSolver = NewSolver(q->numLanes, &so);
+    if (q->wideSolver == NULL) {
+        fprintf(stderr, "Error: Out of memory starting %d threads\n", q->numLanes);
+        BlockInterrupts(0);
+        pthread_mutex_destroy(&q->mu);
+        pthread_cond_destroy(&q->changed);
+        free(q);
+        return 0;
+    }
+    pthread_t *lanes = (pthread_t *)malloc(q->numLanes * sizeof(pthread_t));
+    for (int i = 0; i < q->numLanes; i++) {
+        pthread_create(&lanes[i], NULL, ServeLane, q);
+    }
+    BlockInterrupts(0);
+    int ok = 1;
+    if (path) {
+        ok = ServeSocket(q, path);
+    } else {
+        ServeConn *c = NewServeConn(STDOUT_FILENO);
+        ServeStream(q, stdin, c);
+        ReleaseServeConn(c);
+    }
 
-    //While Within Valid Step
-    while (step < maxSteps) {
-        
-        int numConflicts = 0;
+    pthread_mutex_lock(&q->mu);
+    q->closed = 1;
+    pthread_cond_broadcast(&q->changed);
+    pthread_mutex_unlock(&q->mu);
+    for (int i = 0; i < q->numLanes; i++) {
+        pthread_join(lanes[i], NULL);
+    }
+    free(lanes);
+    DeleteSolver(q->wideSolver);
+    pthread_mutex_destroy(&q->mu);
+    pthread_cond_destroy(&q->changed);
+    free(q);
+    return ok;
+}
 
-        // Collect columns with conflicts
-        for (int col = 0; col < n; col++) {
-            if (HasConflict(board, col)) {
-                conflictCols[numConflicts++] = col;
+int main(int argc, char **argv) {
+
+    //Defaults, Everything Can Be Changed From The Command Line
+    BenchOptions opt;
+    memset(&opt, 0, sizeof(opt));
+    int defaultSize = 100;
+    opt.sizes = (int *)malloc(sizeof(int));
+    opt.sizes[0] = defaultSize;
+    opt.numSizes = 1;
+    opt.reps = -1; //5, Or 1 With A Checkpoint
+    opt.stepFactor = 10;
+    opt.sampleMisses = 8;
+    opt.portfolio = 1;
+    opt.stallWindow = 64;
+    opt.checkpointEvery = 60;
+    opt.seed = (uint64_t)time(NULL); //Based on current time, SO UNIQUE
+    opt.outputFormat = OUTPUT_GRID;
+    int checkInput = argc == 1; //Assignment Default: Just Check input.txt
+    const char *checkPath = "input.txt";
+    int serve = 0;
+    const char *servePath = NULL; //stdin And stdout Unless A Socket Is Given
+    int fanout = SERVE_FANOUT_MIN_N;
+
+    enum {OPT_CSV = 1000, OPT_JSON, OPT_INIT, OPT_ENGINE, OPT_NO_SYMMETRY, OPT_SPLIT_DEPTH, OPT_MODE, OPT_SAMPLE, OPT_SAMPLE_MISSES, OPT_STALL, OPT_DEADLINE, OPT_PROGRESS, OPT_PORTFOLIO,
+          OPT_CHECKPOINT, OPT_CHECKPOINT_EVERY, OPT_SERVE, OPT_FANOUT,
+          OPT_LOCALITY, OPT_TRACE, OPT_PERF};
+    static const struct option longOpts[] = {
+        {"check", optional_argument, NULL, 'c'},
+        {"sizes", required_argument, NULL, 'n'},
+        {"reps", required_argument, NULL, 'r'},
+        {"threads", required_argument, NULL, 't'},
+        {"warmup", required_argument, NULL, 'w'},
+        {"seed", required_argument, NULL, 's'},
+        {"max-steps", required_argument, NULL, 'm'},
+        {"print", required_argument, NULL, 'p'},
+        {"cross-check", no_argument, NULL, 'x'},
+        {"quiet", no_argument, NULL, 'q'},
+        {"init", required_argument, NULL, OPT_INIT},
+        {"engine", required_argument, NULL, OPT_ENGINE},
+        {"no-symmetry", no_argument, NULL, OPT_NO_SYMMETRY},
+        {"split-depth", required_argument, NULL, OPT_SPLIT_DEPTH},
+        {"mode", required_argument, NULL, OPT_MODE},
+        {"sample", required_argument, NULL, OPT_SAMPLE},
+        {"sample-misses", required_argument, NULL, OPT_SAMPLE_MISSES},
+        {"stall", required_argument, NULL, OPT_STALL},
+        {"deadline", required_argument, NULL, OPT_DEADLINE},
+        {"progress", required_argument, NULL, OPT_PROGRESS},
+        {"portfolio", required_argument, NULL, OPT_PORTFOLIO},
+        {"checkpoint", required_argument, NULL, OPT_CHECKPOINT},
+        {"checkpoint-every", required_argument, NULL, OPT_CHECKPOINT_EVERY},
+        {"serve", optional_argument, NULL, OPT_SERVE},
+        {"fanout", required_argument, NULL, OPT_FANOUT},
+        {"locality", no_argument, NULL, OPT_LOCALITY},
+#ifdef NQ_TELEMETRY
+        {"trace", required_argument, NULL, OPT_TRACE},
+        {"perf", no_argument, NULL, OPT_PERF},
+#endif
+        {"csv", required_argument, NULL, OPT_CSV},
+        {"json", required_argument, NULL, OPT_JSON},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0}
+    };
+    int c;
+    while ((c = getopt_long(argc, argv, "c::n:r:t:w:s:m:p:xqh", longOpts, NULL)) != -1) {
+        switch (c) {
+        case 'c':
+            checkInput = 1;
+            if (optarg) {checkPath = optarg;}
+            break;
+        case 'n':
+            if ((opt.numSizes = ParseIntList(optarg, &opt.sizes)) < 0) {
+                fprintf(stderr, "Error: Bad size list '%s'\n", optarg);
+                return 1;
             }
+            break;
+        case 't':
+            if ((opt.numThreads = ParseIntList(optarg, &opt.threads)) < 0) {
+                fprintf(stderr, "Error: Bad thread list '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        case 'r': opt.reps = atoi(optarg); break;
+        case 'w': opt.warmup = atoi(optarg); break;
+        case 's': opt.seed = strtoull(optarg, NULL, 0); break;
+        case 'm': {
+            char *end;
+            opt.stepFactor = strtod(optarg, &end);
+            if (end == optarg || *end != '\0') {
+                fprintf(stderr, "Error: Bad max-steps factor '%s'\n", optarg);
+                return 1;
+            }
+            break;
         }
+        case 'p':
+            opt.printSolution = 1;
+            if (strcmp(optarg, "grid") == 0) {opt.outputFormat = OUTPUT_GRID;}
+            else if (strcmp(optarg, "perm") == 0) {opt.outputFormat = OUTPUT_PERMUTATION;}
+            else if (strcmp(optarg, "bin") == 0) {opt.outputFormat = OUTPUT_BINARY;}
+            else {
+                fprintf(stderr, "Error: Unknown output format '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        case 'x': opt.crossCheck = 1; break;
+        case 'q': opt.quiet = 1; break;
+        case OPT_INIT:
+            if (strcmp(optarg, "random") == 0) {opt.init = INIT_RANDOM;}
+            else if (strcmp(optarg, "perm") == 0) {opt.init = INIT_PERMUTATION;}
+            else if (strcmp(optarg, "greedy") == 0) {opt.init = INIT_GREEDY;}
+            else {
+                fprintf(stderr, "Error: Unknown init '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        case OPT_ENGINE:
+            if (strcmp(optarg, "minconflicts") == 0) {opt.engine = ENGINE_MIN_CONFLICTS;}
+            else if (strcmp(optarg, "swap") == 0) {opt.engine = ENGINE_SWAP;}
+            else if (strcmp(optarg, "construct") == 0) {opt.engine = ENGINE_CONSTRUCT;}
+            else if (strcmp(optarg, "count") == 0) {opt.engine = ENGINE_COUNT;}
+            else {
+                fprintf(stderr, "Error: Unknown engine '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        case OPT_NO_SYMMETRY: opt.noSymmetry = 1; break;
+        case OPT_SPLIT_DEPTH: opt.splitDepth = atoi(optarg); break;
+        case OPT_MODE:
+            if (strcmp(optarg, "atomic") == 0) {opt.stepMode = STEP_ATOMIC;}
+            else if (strcmp(optarg, "bulk") == 0) {opt.stepMode = STEP_BULK;}
+            else if (strcmp(optarg, "async") == 0) {opt.stepMode = STEP_ASYNC;}
+            else {
+                fprintf(stderr, "Error: Unknown mode '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        case OPT_SAMPLE: opt.sampleRows = strcmp(optarg, "auto") == 0 ? SAMPLE_AUTO : atoi(optarg); break;
+        case OPT_SAMPLE_MISSES: opt.sampleMisses = atoi(optarg); break;
+        case OPT_STALL: opt.stallWindow = atoi(optarg); break;
+        case OPT_DEADLINE: opt.deadline = atof(optarg); break;
+        case OPT_PROGRESS: opt.progressEvery = atoi(optarg); break;
+        case OPT_PORTFOLIO: opt.portfolio = atoi(optarg); break;
+        case OPT_CHECKPOINT: opt.checkpoint = optarg; break;
+        case OPT_CHECKPOINT_EVERY: opt.checkpointEvery = atof(optarg); break;
+        case OPT_SERVE:
+            serve = 1;
+            servePath = optarg;
+            break;
+        case OPT_FANOUT: fanout = atoi(optarg); break;
+        case OPT_LOCALITY: opt.locality = 1; break;
+#ifdef NQ_TELEMETRY
+        case OPT_TRACE: opt.tracePath = optarg; break;
+        case OPT_PERF: opt.tracePerf = 1; break;
+#endif
+        case OPT_CSV: opt.csvPath = optarg; break;
+        case OPT_JSON: opt.jsonPath = optarg; break;
+        case 'h': PrintUsage(argv[0]); return 0;
+        default: PrintUsage(argv[0]); return 1;
+        }
+    }
+    if (opt.reps == -1) {
+        opt.reps = opt.checkpoint ? 1 : 5;
+    }
+    if (opt.reps < 1 || opt.warmup < 0 || opt.stepFactor <= 0 || (opt.sampleRows < 0 && opt.sampleRows != SAMPLE_AUTO) || opt.sampleMisses < 1 || opt.splitDepth < 0 || opt.portfolio < 1 || opt.stallWindow < 0 ||
+        opt.deadline < 0 || opt.progressEvery < 0 || opt.checkpointEvery <= 0) {
+        fprintf(stderr, "Error: reps, max-steps, sample-misses, portfolio and checkpoint-every must be positive, "
+                        "warmup, sample, split-depth, stall, deadline and progress non-negative\n");
+        return 1;
+    }
+    if (opt.portfolio > 1 && opt.engine == ENGINE_COUNT) {
+        fprintf(stderr, "Error: --portfolio does not apply to --engine count\n");
+        return 1;
+    }
+    if (opt.checkpoint && (opt.engine != ENGINE_MIN_CONFLICTS || opt.stepMode == STEP_ASYNC || opt.portfolio > 1)) {
+        fprintf(stderr, "Error: --checkpoint applies to min-conflicts steps only, without --mode async or --portfolio\n");
+        return 1;
+    }
+    if (opt.checkpoint && (opt.numSizes > 1 || opt.numThreads > 1 || opt.reps > 1 || opt.warmup > 0)) {
+        fprintf(stderr, "Error: --checkpoint takes one size, one thread count, one run and no warmup\n");
+        return 1;
+    }
+    if (opt.locality && (opt.portfolio > 1 || serve)) {
+        fprintf(stderr, "Error: --locality does not apply to --portfolio or --serve\n");
+        return 1;
+    }
 
-        //If Solved
-        if (numConflicts == 0) {
+    InitGridRowScan();
 
-            //Display Time Taken
-            clock_gettime(CLOCK_MONOTONIC, &end);
-            double duration = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_sec) / 1e9;
-            printf(" -- Solution found in %.3f seconds \n", duration);
-            printf(" -- Solution found in %d (%d) sets of steps \n", step, step*numCPU);
+    //If Checking Input Is Valid
+    if (checkInput){
+        return ValidateFile(checkPath) ? 0 : 1;
+    }
+    //Otherwise Solving Random Tests
 
-            //Validate Solution
-            if (ValidateSolution(board->queens, n)){
-                printf(" -- Solution is valid!\n\n");
+    if (opt.numThreads == 0) {
+        int numCPU = sysconf(_SC_NPROCESSORS_ONLN);
+        if (numCPU < 1) {
+            numCPU = 1;
+        }
+        opt.threads = (int *)malloc(sizeof(int));
+        opt.threads[0] = numCPU;
+        opt.numThreads = 1;
+    }
 
-                //Print Solution To File
-                if (printSolution){
-                    PrintSolutionToFile(board->queens, n, run_num, run_total);
-                }
-                
-            } else {printf(" -- ERROR: Invalid solution found\n");}
-
-            //Delete Board and memory
-            DeleteBoard(board);
-            free(conflictCols);
-            free(threadPool);
-            free(threadDataPool);
-            return duration;
+    //Service Mode Answers Requests Until Its Input Ends
+    if (serve) {
+        if (opt.numThreads > 1 || opt.portfolio > 1 || opt.checkpoint || fanout < 1) {
+            fprintf(stderr, "Error: --serve takes one thread count and a positive --fanout, no --portfolio or --checkpoint\n");
+            return 1;
         }
+        return Serve(&opt, servePath, fanout) ? 0 : 1;
+    }
+    //Reports On stdout Replace The Per-Run Lines
+    if ((opt.csvPath && strcmp(opt.csvPath, "-") == 0) || (opt.jsonPath && strcmp(opt.jsonPath, "-") == 0)) {
+        opt.quiet = 1;
+    }
 
-        // Shuffle conflict columns to randomize processing order
-        for (int i = numConflicts - 1; i > 0; i--) {
-            int j = xorshift() % (i + 1);
-            int temp = conflictCols[i];
-            conflictCols[i] = conflictCols[j];
-            conflictCols[j] = temp;
+#ifdef NQ_TELEMETRY
+    //Trace File And A Probe That perf_event_open Works Here
+    if (opt.tracePath) {
+        opt.trace = fopen(opt.tracePath, "w");
+        if (opt.trace == NULL) {
+            fprintf(stderr, "Error: Cannot open %s\n", opt.tracePath);
+            return 1;
+        }
+        fputs(TRACE_HEADER, opt.trace);
+    }
+    if (opt.tracePerf && !PerfAvailable()) {
+        fprintf(stderr, "Warning: perf_event_open unavailable (%s), perf columns stay 0\n", strerror(errno));
+        opt.tracePerf = 0;
+    }
+#endif
+
+    //Master Seed; Each Run Draws Its Own
+    uint64_t master = opt.seed;
+    SolutionWriter *writer = opt.printSolution ? NewSolutionWriter(opt.outputFormat) : NULL;
+
+    int numConfigs = opt.numThreads * opt.numSizes;
+    BenchConfig *configs = (BenchConfig *)calloc(numConfigs, sizeof(BenchConfig));
+    int cfg = 0;
+
+    //One Solver Per Thread Count, Reused By Every Run
+    signal(SIGINT, OnInterrupt);
+    signal(SIGTERM, OnInterrupt);
+    SolverOptions solverOpt = SolverOptionsFor(&opt);
+    int status = 0;
+    for (int ti = 0; ti < opt.numThreads && !atomic_load(&interrupted); ti++) {
+        int numThreads = opt.threads[ti];
+        Solver *solver = NewSolver(numThreads, &solverOpt);
+        if (solver == NULL) {
+            fprintf(stderr, "Error: Out of memory starting %d threads\n", numThreads);
+            status = 1;
+            break;
         }
 
-        // Divide conflict columns among workers
-        int chunkSize = (numConflicts + numCPU - 1) / numCPU;
+        //For Every Test Size
+        for (int idx = 0; idx < opt.numSizes && !atomic_load(&interrupted); idx++, cfg++) {
+
+            int n = opt.sizes[idx];
+            int maxSteps = MaxSteps(&opt, n);
+            BenchConfig *bc = &configs[cfg];
+            bc->n = n;
+            bc->threads = numThreads;
+            bc->portfolio = SolverMembers(solver);
+            bc->reps = opt.reps;
+            bc->init = opt.init == INIT_GREEDY ? "greedy" : opt.init == INIT_PERMUTATION ? "perm" : "random";
+            bc->engine = opt.engine == ENGINE_SWAP ? "swap" : opt.engine == ENGINE_CONSTRUCT ? "construct" :
+                          opt.engine == ENGINE_COUNT ? "count" : "minconflicts";
+            bc->mode = opt.stepMode == STEP_BULK ? "bulk" : opt.stepMode == STEP_ASYNC ? "async" : "atomic";
+            bc->runs = (SolveResult *)calloc(opt.reps, sizeof(SolveResult));
+
+            //Warm Caches, Pages And The Pool Without Recording
+            for (int x = 0; x < opt.warmup; x++) {
+                Solve(solver, n, maxSteps, NextSeed(&master));
+            }
 
-        //Allocate Work For Threads
-        int numThreads = 0;
-        for (int i = 0; i < numCPU; i++) {
-            int start = i * chunkSize;
-            int end = start + chunkSize;
-            if (end > numConflicts) {
-                end = numConflicts;
+            if (!opt.quiet) {
+                printf("Starting Tests Of Size %d On %d Threads\n", n, numThreads);
             }
-            if (start >= end) {
-                break;
+            //Run Quantity of Tests
+            int x;
+            for (x = 0; x < opt.reps && !atomic_load(&interrupted); x++){
+                SolveResult *r = &bc->runs[x];
+                *r = Solve(solver, n, maxSteps, NextSeed(&master));
+                if (!opt.quiet) {
+                    PrintRun(&opt, solver, r, n);
+                }
+
+                //Queue Solution For The Background Writer, Which Times The Write
+                if (writer && r->status == SOLVE_SOLVED && opt.engine != ENGINE_COUNT) {
+                    SubmitSolution(writer, SolverQueens(solver), n, x, opt.reps, &r->outputTime);
+                }
+            }
+            bc->reps = x; //Fewer If Interrupted
+            if (writer) {
+                FlushSolutionWriter(writer);
             }
-            //Add Work To Threads
-            threadDataPool[i].board = board;
-            threadDataPool[i].cols = &conflictCols[start];
-            threadDataPool[i].numCols = end - start;
-            
-            //Set Them Going
-            pthread_create(&threadPool[i], NULL, MinimizeConflictsThread, &threadDataPool[i]);
-            numThreads++;
-        }
 
-        // Wait for all workers to finish
-        for (int i = 0; i < numThreads; i++) {
-            pthread_join(threadPool[i], NULL);
+            //Return Summary Over Solved Runs
+            if (!opt.quiet) {
+                Stats time, steps;
+                double phases[4];
+                int solved = SummarizeConfig(bc, &time, &steps, phases);
+                printf("\n\n %d OF %d RANDOM n=%d BOARDS SOLVED, SOLVE TIME min %.6f / median %.6f / p95 %.6f / max %.6f s\n",
+                       solved, bc->reps, n, time.min, time.median, time.p95, time.max);
+                printf(" PHASES (mean): init %.6f  loop %.6f  validate %.6f  output %.6f s\n",
+                       phases[0], phases[1], phases[2], phases[3]);
+                if (opt.engine == ENGINE_COUNT && solved) {
+                    printf(" COUNT: %llu solutions at %.3g nodes/s\n",
+                           (unsigned long long)ConfigSolutions(bc), ConfigNodeRate(bc));
+                }
+                printf("\n\n");
+            }
         }
-
-        step++;
+        DeleteSolver(solver);
     }
-    //Free board and memory
-    free(conflictCols);
-    free(threadPool);
-    free(threadDataPool);
-    DeleteBoard(board);
-    printf(" -- ERROR Solution NOT found in %d sets of steps\n", step);
-    return 0; // No solution found
-}
-
-
-
-int main() {
-
-    int boardSizes[] = {100};
-    int testQuantity = 5;
-    int checkInput = 1; //1 = True, 0 = False
-    int printSolution = 1; //1 = True, 0 = False
-
-    random_state = (uint32_t)time(NULL); //Based on current time, SO UNIQUE
+    DeleteSolutionWriter(writer);
 
-    //If Checking Input Is Valid
-    if (checkInput){
-        file_input();
-        return 0;
+    if (opt.csvPath) {
+        WriteBenchCSV(opt.csvPath, configs, cfg);
     }
-    //Otherwise Solving Random Tests
-
-    int numCPU = sysconf(_SC_NPROCESSORS_ONLN);
-    
-    if (numCPU < 1) {
-        numCPU = 1;
+    if (opt.jsonPath) {
+        WriteBenchJSON(opt.jsonPath, configs, cfg, opt.seed);
     }
-    int numSizes = sizeof(boardSizes) / sizeof(boardSizes[0]);
 
-    //For Every Test Size
-    for (int idx = 0; idx < numSizes; idx++) {
-
-        int n = boardSizes[idx];
-        int maxSteps = n * 10;
-        printf("Starting Tests Of Size %d\n", n);
-        double total_time = 0;
-
-        //Run Quantity of Tests
-        for (int x = 0; x < testQuantity; x++){
-            total_time += SolveParallel(n, maxSteps, numCPU, x, testQuantity, printSolution);
-        }
-        //Return Average
-        printf("\n\n AVERAGE FOR %d RANDOM n=%d BOARD:  %.3f s\n\n\n", testQuantity, n, total_time/testQuantity);
+#ifdef NQ_TELEMETRY
+    if (opt.trace) {
+        fclose(opt.trace);
     }
-    return 0;
+#endif
+    for (int i = 0; i < numConfigs; i++) {
+        free(configs[i].runs);
+    }
+    free(configs);
+    free(opt.sizes);
+    free(opt.threads);
+    return status;
 }
@@ -0,0 +1,3808 @@
+#define _GNU_SOURCE // pthread_setaffinity_np and the CPU_SET macros
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <sched.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#ifdef NQ_TELEMETRY
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <errno.h>
+#endif
+
+#include "nqueens.h"
+#include "nqueens_time.h"
+
+// Counter Widths And The Value Past Which An Increment Marks Them Saturated.
+// Three narrow counters must add up without wrapping in the vector kernels
+#define COUNTER8_LIMIT  80
+#define COUNTER16_LIMIT 20000
+#define COUNTER32_LIMIT (INT_MAX / 4)
+
+// Every solve starts on 1-byte counters. The busiest line of a random start
+// holds about log(n)/log(log(n)) queens, far below COUNTER8_LIMIT for any
+// int n, and no placement gives a tighter bound worth planning for; a board
+// that does pass the limit is widened to 2, then 4 bytes by WidenCounters
+#define COUNTER_START_BYTES 1
+
+// One array of line counters, stored 1, 2 or 4 bytes wide
+typedef union {
+    void *raw;
+    atomic_uchar *u8;
+    atomic_ushort *u16;
+    atomic_int *i32;
+} CounterArray;
+
+// Board represents the N-Queens board
+typedef struct {
+    int n;
+    int capacity; // Largest n the arrays are sized for, boards are reused
+    int queensCapacity; // queens alone can be larger, for constructed boards
+    int *queens;
+
+    // Queens per row and diagonal, counterBytes wide. An increment starting
+    // at counterLimit or above sets saturated and the solver widens them
+    int counterBytes;
+    int counterLimit;
+    atomic_int saturated;
+    CounterArray rowConflicts;
+    CounterArray diag1Conflicts;
+    CounterArray diag2Conflicts;
+    int countersMapped; // The counters live in a checkpoint file, not the heap
+    int deferClear;     // ResetBoard leaves the zeroing to ClearBoardTask on the pool
+
+    // XOR of (col + 1) over the queens on each line, only kept exact between
+    // steps; when a line holds one queen this names its column
+    int *rowXor;
+    int *diag1Xor;
+    int *diag2Xor;
+
+    // Live set of conflicted columns, conflictIndex[col] is -1 when absent
+    int *conflictList;
+    int *conflictIndex;
+    int numConflicts;
+} Board;
+
+// Bits returned by UpdateQueen for lines whose counter crossed a threshold
+#define CROSS_OLD_ROW   0x01 // 2 -> 1 on the row left behind
+#define CROSS_OLD_DIAG1 0x02
+#define CROSS_OLD_DIAG2 0x04
+#define CROSS_NEW_ROW   0x08 // 1 -> 2 on the row moved into
+#define CROSS_NEW_DIAG1 0x10
+#define CROSS_NEW_DIAG2 0x20
+
+// What happened to one column during a step, fromRow is -1 if it did not move
+typedef struct {
+    int fromRow;
+    int crossed;
+} MoveRecord;
+
+// Function to compute absolute value
+static int abs_int(int x) { return x < 0 ? -x : x; }
+
+// xoshiro256** generator. Each worker owns one, aligned to its own cache
+// line so tie-breaking never bounces a line between cores
+typedef struct {
+    _Alignas(64) uint64_t s[4];
+} Rng;
+
+// splitmix64, used to expand one seed into a full xoshiro state
+static uint64_t SplitMix64(uint64_t *x) {
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static inline uint64_t RotL(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+// Seed a generator from a single 64-bit value
+static void SeedRng(Rng *r, uint64_t seed) {
+    for (int i = 0; i < 4; i++) {
+        r->s[i] = SplitMix64(&seed);
+    }
+}
+
+// Function to find next random state
+static inline uint64_t NextRng(Rng *r) {
+    uint64_t *s = r->s;
+    uint64_t result = RotL(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = RotL(s[3], 45);
+    return result;
+}
+
+// Uniform value in [0, bound) by multiply-shift, no division on the hot path
+static inline uint32_t RandomBelow(Rng *r, uint32_t bound) {
+    return (uint32_t)(((NextRng(r) >> 32) * bound) >> 32);
+}
+
+// Advance r by 2^128 draws, giving non-overlapping streams from one seed
+static void JumpRng(Rng *r) {
+    static const uint64_t jump[4] = {0x180EC6D33CFD0ABAull, 0xD5A61266F0C9392Cull,
+                                     0xA9582618E03FC9AAull, 0x39ABDC4529B1661Cull};
+    uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    for (int i = 0; i < 4; i++) {
+        for (int b = 0; b < 64; b++) {
+            if (jump[i] & (1ull << b)) {
+                s0 ^= r->s[0];
+                s1 ^= r->s[1];
+                s2 ^= r->s[2];
+                s3 ^= r->s[3];
+            }
+            NextRng(r);
+        }
+    }
+    r->s[0] = s0;
+    r->s[1] = s1;
+    r->s[2] = s2;
+    r->s[3] = s3;
+}
+
+// Bump allocator owned by one worker. It is sized once for the largest solve
+// seen and handed out again on every run, so steps never touch the heap
+typedef struct {
+    char *base;
+    size_t size;
+    size_t used;
+} Arena;
+
+// Make room for at least bytes, discarding whatever was handed out before.
+// Returns 0, with the arena left empty, if the memory cannot be had
+static int ArenaReserve(Arena *a, size_t bytes) {
+    a->used = 0;
+    if (bytes <= a->size) {
+        return 1;
+    }
+    free(a->base);
+    a->size = (bytes + 63) & ~(size_t)63;
+    a->base = (char *)aligned_alloc(64, a->size);
+    if (a->base == NULL) {
+        a->size = 0;
+        return 0;
+    }
+    return 1;
+}
+
+// Carve a 64-byte aligned block out of the arena
+static void *ArenaAlloc(Arena *a, size_t bytes) {
+    void *p = a->base + a->used;
+    a->used += (bytes + 63) & ~(size_t)63;
+    return p;
+}
+
+// Release the arena's memory
+static void ArenaFree(Arena *a) {
+    free(a->base);
+    a->base = NULL;
+    a->size = 0;
+    a->used = 0;
+}
+
+
+// Spin Iterations Before A Waiting Thread Parks In The Kernel
+#define POOL_SPIN_LIMIT 4096
+
+// Task run by every worker of the pool, worker 0 is the calling thread
+typedef void (*PoolTask)(void *arg, int worker);
+
+// WorkerPool keeps numWorkers-1 threads parked between dispatches so a step
+// costs a generation bump and a wake instead of pthread_create/join
+typedef struct WorkerPool {
+    int numWorkers;
+    pthread_t *threads;
+    PoolTask task;
+    void *arg;
+    atomic_uint generation;  // Bumped once per dispatch, futex word for workers
+    atomic_uint pending;     // Workers still running the task, futex word for caller
+    atomic_int sleepers;     // Workers parked on generation
+    atomic_int callerAsleep; // Caller parked on pending
+    atomic_int shutdown;
+} WorkerPool;
+
+// Arguments handed to each pool thread on creation
+typedef struct {
+    WorkerPool *pool;
+    int worker;
+} PoolThreadArgs;
+
+// Hint To The CPU That We Are Busy Waiting
+static inline void CpuRelax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+// Sleep Until *addr No Longer Holds val
+static void FutexWait(atomic_uint *addr, unsigned val) {
+    syscall(SYS_futex, (uint32_t *)addr, FUTEX_WAIT_PRIVATE, val, NULL, NULL, 0);
+}
+
+// Wake Up To count Threads Sleeping On addr
+static void FutexWake(atomic_uint *addr, int count) {
+    syscall(SYS_futex, (uint32_t *)addr, FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0);
+}
+
+// Body of every background pool thread
+static void *PoolThreadMain(void *p) {
+    PoolThreadArgs args = *(PoolThreadArgs *)p;
+    WorkerPool *pool = args.pool;
+    free(p);
+
+    unsigned seen = 0;
+    for (;;) {
+        //Wait For The Next Dispatch, Spinning Briefly Before Parking
+        unsigned gen;
+        int spins = 0;
+        while ((gen = atomic_load_explicit(&pool->generation, memory_order_acquire)) == seen) {
+            if (spins < POOL_SPIN_LIMIT) {
+                spins++;
+                CpuRelax();
+            } else {
+                atomic_fetch_add(&pool->sleepers, 1);
+                FutexWait(&pool->generation, seen);
+                atomic_fetch_sub(&pool->sleepers, 1);
+            }
+        }
+        seen = gen;
+
+        if (atomic_load_explicit(&pool->shutdown, memory_order_acquire)) {
+            return NULL;
+        }
+
+        pool->task(pool->arg, args.worker);
+
+        //Last One Out Wakes The Caller If It Went To Sleep
+        if (atomic_fetch_sub_explicit(&pool->pending, 1, memory_order_acq_rel) == 1 &&
+            atomic_load(&pool->callerAsleep)) {
+            FutexWake(&pool->pending, 1);
+        }
+    }
+}
+
+// Stop and join all pool threads
+static void DeleteWorkerPool(WorkerPool *pool) {
+    if (pool == NULL){return;}
+    atomic_store(&pool->shutdown, 1);
+    atomic_fetch_add(&pool->generation, 1);
+    FutexWake(&pool->generation, pool->numWorkers);
+    for (int i = 1; i < pool->numWorkers; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    free(pool->threads);
+    free(pool);
+}
+
+// Create a pool of numWorkers workers (numWorkers-1 threads plus the caller),
+// NULL if out of memory or threads
+static WorkerPool *NewWorkerPool(int numWorkers) {
+    if (numWorkers < 1) {
+        numWorkers = 1;
+    }
+    WorkerPool *pool = (WorkerPool *)calloc(1, sizeof(WorkerPool));
+    if (pool == NULL) {
+        return NULL;
+    }
+    pool->numWorkers = numWorkers;
+    pool->threads = (pthread_t *)malloc(numWorkers * sizeof(pthread_t));
+    if (pool->threads == NULL) {
+        free(pool);
+        return NULL;
+    }
+    atomic_store(&pool->generation, 0);
+    atomic_store(&pool->pending, 0);
+    atomic_store(&pool->sleepers, 0);
+    atomic_store(&pool->callerAsleep, 0);
+    atomic_store(&pool->shutdown, 0);
+
+    for (int i = 1; i < numWorkers; i++) {
+        PoolThreadArgs *args = (PoolThreadArgs *)malloc(sizeof(PoolThreadArgs));
+        if (args != NULL) {
+            args->pool = pool;
+            args->worker = i;
+        }
+        if (args == NULL || pthread_create(&pool->threads[i], NULL, PoolThreadMain, args) != 0) {
+            //Shut Down The Threads Already Started
+            free(args);
+            pool->numWorkers = i;
+            DeleteWorkerPool(pool);
+            return NULL;
+        }
+    }
+    return pool;
+}
+
+// Run task(arg, worker) on every worker and return once all have finished
+static void RunWorkerPool(WorkerPool *pool, PoolTask task, void *arg) {
+    if (pool->numWorkers == 1) {
+        task(arg, 0);
+        return;
+    }
+
+    //Publish Task, Then Release Workers
+    pool->task = task;
+    pool->arg = arg;
+    atomic_store_explicit(&pool->pending, pool->numWorkers - 1, memory_order_relaxed);
+    atomic_fetch_add(&pool->generation, 1);
+    if (atomic_load(&pool->sleepers) > 0) {
+        FutexWake(&pool->generation, pool->numWorkers - 1);
+    }
+
+    //Caller Does Its Own Share
+    task(arg, 0);
+
+    //Wait For The Rest
+    int spins = 0;
+    unsigned left;
+    while ((left = atomic_load_explicit(&pool->pending, memory_order_acquire)) != 0) {
+        if (spins < POOL_SPIN_LIMIT) {
+            spins++;
+            CpuRelax();
+        } else {
+            atomic_store(&pool->callerAsleep, 1);
+            FutexWait(&pool->pending, left);
+            atomic_store(&pool->callerAsleep, 0);
+        }
+    }
+}
+
+// Chase-Lev work-stealing deque of column indexes. Only the owner pushes, at
+// the bottom; everyone takes from the top. The owner taking its own oldest
+// entry rather than popping the newest keeps a queen that just moved from
+// being revisited straight away, which would only bounce it between two
+// rows. Fences follow Le et al., "Correct and Efficient Work-Stealing for
+// Weak Memory Models" (PPoPP 2013)
+#define DEQUE_EMPTY -1
+#define DEQUE_ABORT -2
+
+typedef struct {
+    _Alignas(64) atomic_long top;
+    _Alignas(64) atomic_long bottom;
+    atomic_int *buf;
+    long mask; // Capacity - 1, capacity a power of two
+} Deque;
+
+// Empty the deque and point it at a buffer of mask + 1 slots
+static void ResetDeque(Deque *d, atomic_int *buf, long mask) {
+    atomic_store(&d->top, 0);
+    atomic_store(&d->bottom, 0);
+    d->buf = buf;
+    d->mask = mask;
+}
+
+// Owner only. The caller keeps the deque from ever holding more than
+// capacity entries
+static void PushDeque(Deque *d, int x) {
+    long b = atomic_load_explicit(&d->bottom, memory_order_relaxed);
+    atomic_store_explicit(&d->buf[b & d->mask], x, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+}
+
+// Any thread, oldest entry first. DEQUE_ABORT means another thief won
+static int StealDeque(Deque *d) {
+    long t = atomic_load_explicit(&d->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long b = atomic_load_explicit(&d->bottom, memory_order_acquire);
+    if (t >= b) {
+        return DEQUE_EMPTY;
+    }
+    int x = atomic_load_explicit(&d->buf[t & d->mask], memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1, memory_order_seq_cst,
+                                                 memory_order_relaxed)) {
+        return DEQUE_ABORT;
+    }
+    return x;
+}
+
+
+
+// Read one line counter
+static inline int GetCounter(const Board *b, CounterArray c, long i) {
+    switch (b->counterBytes) {
+    case 1: return atomic_load_explicit(&c.u8[i], memory_order_relaxed);
+    case 2: return atomic_load_explicit(&c.u16[i], memory_order_relaxed);
+    default: return atomic_load_explicit(&c.i32[i], memory_order_relaxed);
+    }
+}
+
+// Add delta (+1 or -1) to one line counter and return its previous value
+static inline int AddCounter(Board *b, CounterArray c, long i, int delta) {
+    int old;
+    switch (b->counterBytes) {
+    case 1: old = atomic_fetch_add(&c.u8[i], (unsigned char)delta); break;
+    case 2: old = atomic_fetch_add(&c.u16[i], (unsigned short)delta); break;
+    default: old = atomic_fetch_add(&c.i32[i], delta); break;
+    }
+    if (delta > 0 && old >= b->counterLimit) {
+        atomic_store_explicit(&b->saturated, 1, memory_order_relaxed);
+    }
+    return old;
+}
+
+// Saturation limit of counters bytes wide
+static inline int CounterLimit(int bytes) {
+    return bytes == 1 ? COUNTER8_LIMIT : bytes == 2 ? COUNTER16_LIMIT : COUNTER32_LIMIT;
+}
+
+// Zero the counters at the given width, reallocating only if the width
+// changed since the last solve on this board. Counters mapped from a
+// checkpoint file are left there and the new width goes on the heap.
+// Returns 0, with no counters left, if they cannot be allocated
+static int AllocCounters(Board *b, int bytes) {
+    b->counterLimit = CounterLimit(bytes);
+    atomic_store(&b->saturated, 0);
+    if (bytes == b->counterBytes && b->rowConflicts.raw != NULL) {
+        if (!b->deferClear) {
+            memset(b->rowConflicts.raw, 0, (size_t)b->n * bytes);
+            memset(b->diag1Conflicts.raw, 0, (size_t)2 * b->n * bytes);
+            memset(b->diag2Conflicts.raw, 0, (size_t)2 * b->n * bytes);
+        }
+        return 1;
+    }
+    if (b->countersMapped) {
+        b->rowConflicts.raw = b->diag1Conflicts.raw = b->diag2Conflicts.raw = NULL;
+        b->countersMapped = 0;
+    }
+    free(b->rowConflicts.raw);
+    free(b->diag1Conflicts.raw);
+    free(b->diag2Conflicts.raw);
+    b->counterBytes = bytes;
+    b->rowConflicts.raw = calloc(b->capacity, bytes);
+    b->diag1Conflicts.raw = calloc(2 * (size_t)b->capacity, bytes);
+    b->diag2Conflicts.raw = calloc(2 * (size_t)b->capacity, bytes);
+    if (b->rowConflicts.raw == NULL || b->diag1Conflicts.raw == NULL || b->diag2Conflicts.raw == NULL) {
+        free(b->rowConflicts.raw);
+        free(b->diag1Conflicts.raw);
+        free(b->diag2Conflicts.raw);
+        b->rowConflicts.raw = b->diag1Conflicts.raw = b->diag2Conflicts.raw = NULL;
+        return 0;
+    }
+    return 1;
+}
+
+// Recount every line from queens
+static void CountQueens(Board *b) {
+    for (int col = 0; col < b->n; col++) {
+        int row = b->queens[col];
+        AddCounter(b, b->rowConflicts, row, 1);
+        AddCounter(b, b->diag1Conflicts, row - col + b->n, 1);
+        AddCounter(b, b->diag2Conflicts, row + col, 1);
+    }
+}
+
+// Check If Queen At Given Column Has Any Conflicts
+static int HasConflict(Board *b, int col) {
+
+    //Find The Row This Queen Is In (async mode reads it while its owner moves it)
+    int row = atomic_load_explicit((atomic_int *)&b->queens[col], memory_order_relaxed);
+
+    //Determine If Conflict Exists
+    if (GetCounter(b, b->rowConflicts, row) > 1 ||
+        GetCounter(b, b->diag1Conflicts, row - col + b->n) > 1 ||
+        GetCounter(b, b->diag2Conflicts, row + col) > 1) {
+        return 1; // true
+    }
+    return 0; // false
+}
+
+// Rebuild the conflict set with one full scan
+static void RebuildConflictSet(Board *b) {
+    b->numConflicts = 0;
+    for (int col = 0; col < b->n; col++) {
+        b->conflictIndex[col] = -1;
+        if (HasConflict(b, col)) {
+            b->conflictIndex[col] = b->numConflicts;
+            b->conflictList[b->numConflicts++] = col;
+        }
+    }
+}
+
+// Move to the next wider counters after one saturated; queens is the truth
+// so the counters and the conflict set are simply rebuilt from it. Returns
+// 0 if the wider counters cannot be allocated
+static int WidenCounters(Board *b) {
+    if (!AllocCounters(b, b->counterBytes == 1 ? 2 : 4)) {
+        return 0;
+    }
+    CountQueens(b);
+    RebuildConflictSet(b);
+    return 1;
+}
+
+// Make room for n queens in queens alone; constructed solutions need no
+// counters, XORs or conflict set. Returns 0 if out of memory
+static int ResizeQueens(Board *board, int n) {
+    if (n > board->queensCapacity) {
+        free(board->queens);
+        board->queens = (int *)malloc((size_t)n * sizeof(int));
+        board->queensCapacity = board->queens != NULL ? n : 0;
+    }
+    return board->queens != NULL;
+}
+
+// Empty an existing board for n queens, growing its arrays only if n is
+// larger than any size it has held before. The queens are placed afterwards
+// by PlaceQueens, then FinishPlacement settles counters and conflicts.
+// Returns 0 if the arrays cannot be allocated; the board then holds none
+// and the next reset starts over
+static int ResetBoard(Board *board, int n) {
+
+    //Grow If Needed, Otherwise Everything Is Reused
+    if (!ResizeQueens(board, n)) {
+        return 0;
+    }
+    if (n > board->capacity) {
+        free(board->rowXor);
+        free(board->diag1Xor);
+        free(board->diag2Xor);
+        free(board->conflictList);
+        free(board->conflictIndex);
+        free(board->rowConflicts.raw);
+        free(board->diag1Conflicts.raw);
+        free(board->diag2Conflicts.raw);
+        board->rowConflicts.raw = NULL;
+        board->diag1Conflicts.raw = NULL;
+        board->diag2Conflicts.raw = NULL;
+        board->capacity = n;
+        board->rowXor = (int *)malloc(n * sizeof(int));
+        board->diag1Xor = (int *)malloc(2 * n * sizeof(int));
+        board->diag2Xor = (int *)malloc(2 * n * sizeof(int));
+        board->conflictList = (int *)malloc(n * sizeof(int));
+        board->conflictIndex = (int *)malloc(n * sizeof(int));
+        if (board->rowXor == NULL || board->diag1Xor == NULL || board->diag2Xor == NULL ||
+            board->conflictList == NULL || board->conflictIndex == NULL) {
+            free(board->rowXor);
+            free(board->diag1Xor);
+            free(board->diag2Xor);
+            free(board->conflictList);
+            free(board->conflictIndex);
+            board->rowXor = board->diag1Xor = board->diag2Xor = NULL;
+            board->conflictList = board->conflictIndex = NULL;
+            board->capacity = 0;
+            return 0;
+        }
+    }
+    board->n = n;
+    board->numConflicts = 0;
+    if (!board->deferClear) {
+        memset(board->rowXor, 0, n * sizeof(int));
+        memset(board->diag1Xor, 0, 2 * n * sizeof(int));
+        memset(board->diag2Xor, 0, 2 * n * sizeof(int));
+    }
+
+    //Counters Start Narrow And Zeroed
+    return AllocCounters(board, COUNTER_START_BYTES);
+}
+
+// Settle a freshly placed board: widen the counters if the start already
+// overflowed them, then seed the conflict set with one full scan. Returns 0
+// if the wider counters cannot be allocated
+static int FinishPlacement(Board *board) {
+    while (atomic_load(&board->saturated)) {
+        if (!AllocCounters(board, board->counterBytes == 1 ? 2 : 4)) {
+            return 0;
+        }
+        CountQueens(board);
+    }
+    RebuildConflictSet(board);
+    return 1;
+}
+
+// Deletes Board
+static void DeleteBoard(Board *board){
+    if (board == NULL){return;}
+    free(board->queens);
+    free(board->rowConflicts.raw);
+    free(board->diag1Conflicts.raw);
+    free(board->diag2Conflicts.raw);
+    free(board->rowXor);
+    free(board->diag1Xor);
+    free(board->diag2Xor);
+    free(board->conflictList);
+    free(board->conflictIndex);
+    free(board);
+}
+
+
+
+
+// Update the queen's position in the board, returning the CROSS_* bits of
+// every line whose counter crossed between one and two queens
+static int UpdateQueen(Board *b, int col, int newRow) {
+    
+    //Find Old Row
+    int oldRow = b->queens[col];
+
+    //If No Movement, Return
+    if (oldRow == newRow) {
+        return 0;
+    }
+
+    int crossed = 0;
+
+    // Remove old conflicts
+    if (AddCounter(b, b->rowConflicts, oldRow, -1) == 2) {crossed |= CROSS_OLD_ROW;}
+    if (AddCounter(b, b->diag1Conflicts, oldRow - col + b->n, -1) == 2) {crossed |= CROSS_OLD_DIAG1;}
+    if (AddCounter(b, b->diag2Conflicts, oldRow + col, -1) == 2) {crossed |= CROSS_OLD_DIAG2;}
+
+    // Place queen at new position
+    b->queens[col] = newRow;
+
+    // Add new conflicts
+    if (AddCounter(b, b->rowConflicts, newRow, 1) == 1) {crossed |= CROSS_NEW_ROW;}
+    if (AddCounter(b, b->diag1Conflicts, newRow - col + b->n, 1) == 1) {crossed |= CROSS_NEW_DIAG1;}
+    if (AddCounter(b, b->diag2Conflicts, newRow + col, 1) == 1) {crossed |= CROSS_NEW_DIAG2;}
+    return crossed;
+}
+
+// Atomically XOR col + 1 into one line's XOR
+static inline void FlipLineXor(int *xors, long i, int col) {
+    atomic_fetch_xor_explicit((atomic_int *)&xors[i], col + 1, memory_order_relaxed);
+}
+
+// UpdateQueen for the asynchronous engine. With no barrier to settle the
+// line XORs at they are kept current atomically, and *excess gets the change
+// in queens beyond the first on each line (zero iff the board is solved)
+static int UpdateQueenAsync(Board *b, int col, int newRow, long *excess) {
+    int n = b->n;
+    int oldRow = b->queens[col];
+    if (oldRow == newRow) {
+        return 0;
+    }
+    long oldLines[3] = {oldRow, oldRow - col + n, oldRow + col};
+    long newLines[3] = {newRow, newRow - col + n, newRow + col};
+    CounterArray counters[3] = {b->rowConflicts, b->diag1Conflicts, b->diag2Conflicts};
+    int *xors[3] = {b->rowXor, b->diag1Xor, b->diag2Xor};
+
+    int crossed = 0;
+    for (int k = 0; k < 3; k++) {
+        FlipLineXor(xors[k], oldLines[k], col);
+        int old = AddCounter(b, counters[k], oldLines[k], -1);
+        if (old >= 2) {(*excess)--;}
+        if (old == 2) {crossed |= CROSS_OLD_ROW << k;}
+    }
+    atomic_store_explicit((atomic_int *)&b->queens[col], newRow, memory_order_relaxed);
+    for (int k = 0; k < 3; k++) {
+        FlipLineXor(xors[k], newLines[k], col);
+        int old = AddCounter(b, counters[k], newLines[k], 1);
+        if (old >= 1) {(*excess)++;}
+        if (old == 1) {crossed |= CROSS_NEW_ROW << k;}
+    }
+    return crossed;
+}
+
+// Bulk-synchronous steps log counter changes instead of applying them. An
+// entry is (line << 3) | (kind << 1) | negative, kind being one of these
+#define DELTA_ROW   0
+#define DELTA_DIAG1 1
+#define DELTA_DIAG2 2
+#define BULK_MAX_N  (1 << 28) // Keeps a diagonal index shifted by 3 in 32 bits
+
+static inline uint32_t EncodeDelta(long line, int kind, int delta) {
+    return (uint32_t)(line << 3) | (uint32_t)(kind << 1) | (delta < 0);
+}
+
+// Worker that merges the line an entry touches: each owns a contiguous
+// slice of the rows and of both diagonal arrays
+static inline int DeltaOwner(const Board *b, uint32_t entry, int numWorkers) {
+    long lines = ((entry >> 1) & 3) == DELTA_ROW ? b->n : 2L * b->n;
+    return (int)((long)(entry >> 3) * numWorkers / lines);
+}
+
+// Apply one logged entry with plain loads and stores. Only the owning
+// worker touches the line, so no atomic read-modify-write is needed. A line
+// can dip below zero part way through its merge, so narrow counters are
+// read as signed to keep a wrapped -1 from looking saturated
+static inline void ApplyDelta(Board *b, uint32_t entry) {
+    int kind = (entry >> 1) & 3;
+    CounterArray c = kind == DELTA_ROW ? b->rowConflicts : kind == DELTA_DIAG1 ? b->diag1Conflicts : b->diag2Conflicts;
+    long i = entry >> 3;
+    int delta = (entry & 1) ? -1 : 1;
+    int old;
+    switch (b->counterBytes) {
+    case 1:
+        old = (signed char)atomic_load_explicit(&c.u8[i], memory_order_relaxed);
+        atomic_store_explicit(&c.u8[i], (unsigned char)(old + delta), memory_order_relaxed);
+        break;
+    case 2:
+        old = (short)atomic_load_explicit(&c.u16[i], memory_order_relaxed);
+        atomic_store_explicit(&c.u16[i], (unsigned short)(old + delta), memory_order_relaxed);
+        break;
+    default:
+        old = atomic_load_explicit(&c.i32[i], memory_order_relaxed);
+        atomic_store_explicit(&c.i32[i], old + delta, memory_order_relaxed);
+        break;
+    }
+    if (delta > 0 && old >= b->counterLimit) {
+        atomic_store_explicit(&b->saturated, 1, memory_order_relaxed);
+    }
+}
+
+// Bring col's membership in the conflict set in line with the counters
+static void RecheckConflict(Board *b, int col) {
+    if (col < 0 || col >= b->n) {
+        return;
+    }
+    int idx = b->conflictIndex[col];
+    if (HasConflict(b, col)) {
+        if (idx < 0) {
+            b->conflictIndex[col] = b->numConflicts;
+            b->conflictList[b->numConflicts++] = col;
+        }
+    } else if (idx >= 0) {
+        int last = b->conflictList[--b->numConflicts];
+        b->conflictList[idx] = last;
+        b->conflictIndex[last] = idx;
+        b->conflictIndex[col] = -1;
+    }
+}
+
+// Fold one step's moves into the conflict set. Runs between steps while no
+// worker is touching the board, so only lines that crossed a threshold and
+// the moved columns themselves need another look
+static void RefreshConflicts(Board *b, int *cols, MoveRecord *moves, int numCols) {
+    int n = b->n;
+
+    //Take Movers Off Their Old Lines, Leaving Each Line's XOR To Non-Movers
+    for (int i = 0; i < numCols; i++) {
+        int row = moves[i].fromRow;
+        if (row < 0) {continue;}
+        int col = cols[i];
+        b->rowXor[row] ^= col + 1;
+        b->diag1Xor[row - col + n] ^= col + 1;
+        b->diag2Xor[row + col] ^= col + 1;
+    }
+
+    //A Line That Went 1 -> 2 May Have Had A Lone Non-Mover, Now Conflicted
+    for (int i = 0; i < numCols; i++) {
+        int crossed = moves[i].crossed;
+        if (moves[i].fromRow < 0 || !(crossed & (CROSS_NEW_ROW | CROSS_NEW_DIAG1 | CROSS_NEW_DIAG2))) {continue;}
+        int col = cols[i];
+        int row = b->queens[col];
+        if (crossed & CROSS_NEW_ROW) {RecheckConflict(b, b->rowXor[row] - 1);}
+        if (crossed & CROSS_NEW_DIAG1) {RecheckConflict(b, b->diag1Xor[row - col + n] - 1);}
+        if (crossed & CROSS_NEW_DIAG2) {RecheckConflict(b, b->diag2Xor[row + col] - 1);}
+    }
+
+    //Put Movers On Their New Lines
+    for (int i = 0; i < numCols; i++) {
+        if (moves[i].fromRow < 0) {continue;}
+        int col = cols[i];
+        int row = b->queens[col];
+        b->rowXor[row] ^= col + 1;
+        b->diag1Xor[row - col + n] ^= col + 1;
+        b->diag2Xor[row + col] ^= col + 1;
+    }
+
+    //A Line That Went 2 -> 1 Leaves A Queen That May Now Be Free
+    for (int i = 0; i < numCols; i++) {
+        int row = moves[i].fromRow;
+        int crossed = moves[i].crossed;
+        if (row < 0 || !(crossed & (CROSS_OLD_ROW | CROSS_OLD_DIAG1 | CROSS_OLD_DIAG2))) {continue;}
+        int col = cols[i];
+        if ((crossed & CROSS_OLD_ROW) && GetCounter(b, b->rowConflicts, row) == 1) {
+            RecheckConflict(b, b->rowXor[row] - 1);
+        }
+        if ((crossed & CROSS_OLD_DIAG1) && GetCounter(b, b->diag1Conflicts, row - col + n) == 1) {
+            RecheckConflict(b, b->diag1Xor[row - col + n] - 1);
+        }
+        if ((crossed & CROSS_OLD_DIAG2) && GetCounter(b, b->diag2Conflicts, row + col) == 1) {
+            RecheckConflict(b, b->diag2Xor[row + col] - 1);
+        }
+    }
+
+    //Finally The Movers Themselves
+    for (int i = 0; i < numCols; i++) {
+        if (moves[i].fromRow >= 0) {
+            RecheckConflict(b, cols[i]);
+        }
+    }
+}
+
+// Row scan kernel: sums rows[r] + d1[r] + d2[r] for r in [0, n), writes every
+// row reaching the minimum into bestRows and returns how many there are.
+// There is one kernel per counter width; narrow sums saturate at the type max.
+// The two-pass vector kernels may return 0 if the counters change under them
+typedef int (*RowScanFn)(const void *rows, const void *d1, const void *d2, int n, int *bestRows);
+
+// Rows per block of the vector kernels; three streams of this length stay
+// in L1 so the gather pass re-reads them for free
+#define SCAN_BLOCK 2048
+
+// Portable one-pass scan, instantiated for each counter type
+#define DEFINE_ROW_SCAN_SCALAR(NAME, T, MAXSUM) \
+static int NAME(const void *rowsv, const void *d1v, const void *d2v, int n, int *bestRows) { \
+    const T *rows = (const T *)rowsv; \
+    const T *d1 = (const T *)d1v; \
+    const T *d2 = (const T *)d2v; \
+    int numBestRows = 0; \
+    int minConflicts = INT_MAX; \
+    for (int row = 0; row < n; row++) { \
+        int conflicts = rows[row] + d1[row] + d2[row]; \
+        if (conflicts > (MAXSUM)) {conflicts = (MAXSUM);} \
+        /*New Best - Replace*/ \
+        if (conflicts < minConflicts) { \
+            bestRows[0] = row; \
+            numBestRows = 1; \
+            minConflicts = conflicts; \
+        /*Tied Best - Add To List*/ \
+        } else if (conflicts == minConflicts) { \
+            bestRows[numBestRows++] = row; \
+        } \
+    } \
+    return numBestRows; \
+}
+
+DEFINE_ROW_SCAN_SCALAR(RowScanScalar8, uint8_t, UINT8_MAX)
+DEFINE_ROW_SCAN_SCALAR(RowScanScalar16, uint16_t, UINT16_MAX)
+DEFINE_ROW_SCAN_SCALAR(RowScanScalar32, int, INT_MAX)
+
+#if defined(__x86_64__) || defined(__i386__)
+
+// Smallest unsigned byte in a 128-bit vector
+__attribute__((target("avx2")))
+static inline int MinEpu8(__m128i v) {
+    v = _mm_min_epu8(v, _mm_srli_epi16(v, 8));
+    return _mm_cvtsi128_si32(_mm_minpos_epu16(v)) & 0xFFFF;
+}
+
+// Smallest unsigned 16-bit lane in a 128-bit vector
+__attribute__((target("avx2")))
+static inline int MinEpu16(__m128i v) {
+    return _mm_cvtsi128_si32(_mm_minpos_epu16(v)) & 0xFFFF;
+}
+
+// Smallest signed 32-bit lane in a 128-bit vector
+__attribute__((target("avx2")))
+static inline int MinEpi32(__m128i v) {
+    v = _mm_min_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm_min_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(v);
+}
+
+// AVX2 scan: per block, a vector min reduction and then a gather of the rows
+// equal to the running minimum via compare masks. LANES is elements per
+// vector, LANE_BITS the movemask bits each element produces
+#define DEFINE_ROW_SCAN_AVX2(NAME, T, MAXSUM, LANES, LANE_BITS, SUM, MIN, CMPEQ, SET1, MOVEMASK, HMIN) \
+__attribute__((target("avx2"))) \
+static int NAME(const void *rowsv, const void *d1v, const void *d2v, int n, int *bestRows) { \
+    const T *rows = (const T *)rowsv; \
+    const T *d1 = (const T *)d1v; \
+    const T *d2 = (const T *)d2v; \
+    int numBestRows = 0; \
+    int minConflicts = INT_MAX; \
+    for (int base = 0; base < n; base += SCAN_BLOCK) { \
+        int end = base + SCAN_BLOCK < n ? base + SCAN_BLOCK : n; \
+        /*Pass 1: Block Minimum*/ \
+        __m256i vmin = SET1(MAXSUM); \
+        int row = base; \
+        for (; row + (LANES) <= end; row += (LANES)) { \
+            __m256i sum = SUM(_mm256_loadu_si256((const __m256i *)&rows[row]), \
+                          SUM(_mm256_loadu_si256((const __m256i *)&d1[row]), \
+                              _mm256_loadu_si256((const __m256i *)&d2[row]))); \
+            vmin = MIN(vmin, sum); \
+        } \
+        int blockMin = HMIN(MIN##_128(_mm256_castsi256_si128(vmin), _mm256_extracti128_si256(vmin, 1))); \
+        for (; row < end; row++) { \
+            int conflicts = rows[row] + d1[row] + d2[row]; \
+            if (conflicts > (MAXSUM)) {conflicts = (MAXSUM);} \
+            if (conflicts < blockMin) {blockMin = conflicts;} \
+        } \
+        /*Nothing Here Beats Or Ties What We Have*/ \
+        if (blockMin > minConflicts) { \
+            continue; \
+        } \
+        if (blockMin < minConflicts) { \
+            minConflicts = blockMin; \
+            numBestRows = 0; \
+        } \
+        /*Pass 2: Gather Rows Equal To The Minimum*/ \
+        __m256i vbest = SET1(minConflicts); \
+        row = base; \
+        for (; row + (LANES) <= end; row += (LANES)) { \
+            __m256i sum = SUM(_mm256_loadu_si256((const __m256i *)&rows[row]), \
+                          SUM(_mm256_loadu_si256((const __m256i *)&d1[row]), \
+                              _mm256_loadu_si256((const __m256i *)&d2[row]))); \
+            unsigned mask = MOVEMASK(CMPEQ(sum, vbest)); \
+            while (mask) { \
+                bestRows[numBestRows++] = row + __builtin_ctz(mask) / (LANE_BITS); \
+                mask &= mask - 1; \
+            } \
+        } \
+        for (; row < end; row++) { \
+            int conflicts = rows[row] + d1[row] + d2[row]; \
+            if (conflicts > (MAXSUM)) {conflicts = (MAXSUM);} \
+            if (conflicts == minConflicts) { \
+                bestRows[numBestRows++] = row; \
+            } \
+        } \
+    } \
+    return numBestRows; \
+}
+
+// Lane helpers the AVX2 template is instantiated with
+#define _mm256_min_epu8_128 _mm_min_epu8
+#define _mm256_min_epu16_128 _mm_min_epu16
+#define _mm256_min_epi32_128 _mm_min_epi32
+#define SET1_EPI8(x) _mm256_set1_epi8((char)(x))
+#define SET1_EPI16(x) _mm256_set1_epi16((short)(x))
+#define MOVEMASK_EPI8(x) ((unsigned)_mm256_movemask_epi8(x))
+#define MOVEMASK_EPI16(x) ((unsigned)_mm256_movemask_epi8(x) & 0x55555555u)
+#define MOVEMASK_EPI32(x) ((unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(x)))
+
+DEFINE_ROW_SCAN_AVX2(RowScanAVX2_8, uint8_t, UINT8_MAX, 32, 1, _mm256_adds_epu8, _mm256_min_epu8,
+                     _mm256_cmpeq_epi8, SET1_EPI8, MOVEMASK_EPI8, MinEpu8)
+DEFINE_ROW_SCAN_AVX2(RowScanAVX2_16, uint16_t, UINT16_MAX, 16, 2, _mm256_adds_epu16, _mm256_min_epu16,
+                     _mm256_cmpeq_epi16, SET1_EPI16, MOVEMASK_EPI16, MinEpu16)
+DEFINE_ROW_SCAN_AVX2(RowScanAVX2_32, int, INT_MAX, 8, 1, _mm256_add_epi32, _mm256_min_epi32,
+                     _mm256_cmpeq_epi32, _mm256_set1_epi32, MOVEMASK_EPI32, MinEpi32)
+
+// AVX-512 scan for 32-bit counters: same two passes, tails use load masks
+// and ties are written with a compress store
+__attribute__((target("avx512f")))
+static int RowScanAVX512_32(const void *rowsv, const void *d1v, const void *d2v, int n, int *bestRows) {
+    const int *rows = (const int *)rowsv;
+    const int *d1 = (const int *)d1v;
+    const int *d2 = (const int *)d2v;
+    int numBestRows = 0;
+    int minConflicts = INT_MAX;
+    const __m512i lanes = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+
+    for (int base = 0; base < n; base += SCAN_BLOCK) {
+        int end = base + SCAN_BLOCK < n ? base + SCAN_BLOCK : n;
+
+        //Pass 1: Block Minimum
+        __m512i vmin = _mm512_set1_epi32(INT_MAX);
+        for (int row = base; row < end; row += 16) {
+            __mmask16 live = end - row >= 16 ? 0xFFFF : (__mmask16)((1u << (end - row)) - 1);
+            __m512i sum = _mm512_add_epi32(_mm512_maskz_loadu_epi32(live, &rows[row]),
+                          _mm512_add_epi32(_mm512_maskz_loadu_epi32(live, &d1[row]),
+                                           _mm512_maskz_loadu_epi32(live, &d2[row])));
+            vmin = _mm512_mask_min_epi32(vmin, live, vmin, sum);
+        }
+        int blockMin = _mm512_reduce_min_epi32(vmin);
+
+        if (blockMin > minConflicts) {
+            continue;
+        }
+        if (blockMin < minConflicts) {
+            minConflicts = blockMin;
+            numBestRows = 0;
+        }
+
+        //Pass 2: Compress The Tied Row Indexes Straight Into bestRows
+        __m512i vbest = _mm512_set1_epi32(minConflicts);
+        for (int row = base; row < end; row += 16) {
+            __mmask16 live = end - row >= 16 ? 0xFFFF : (__mmask16)((1u << (end - row)) - 1);
+            __m512i sum = _mm512_add_epi32(_mm512_maskz_loadu_epi32(live, &rows[row]),
+                          _mm512_add_epi32(_mm512_maskz_loadu_epi32(live, &d1[row]),
+                                           _mm512_maskz_loadu_epi32(live, &d2[row])));
+            __mmask16 tied = _mm512_mask_cmpeq_epi32_mask(live, sum, vbest);
+            __m512i idx = _mm512_add_epi32(_mm512_set1_epi32(row), lanes);
+            _mm512_mask_compressstoreu_epi32(&bestRows[numBestRows], tied, idx);
+            numBestRows += __builtin_popcount(tied);
+        }
+    }
+    return numBestRows;
+}
+
+// AVX-512BW scan for narrow counters: saturating byte/word adds, tied rows
+// are read off the 64/32-bit compare mask
+#define DEFINE_ROW_SCAN_AVX512BW(NAME, T, MAXSUM, LANES, MASK_T, LOADZ, SUM, MASK_MIN, CMPEQ, SET1, REDUCE) \
+__attribute__((target("avx512f,avx512bw"))) \
+static int NAME(const void *rowsv, const void *d1v, const void *d2v, int n, int *bestRows) { \
+    const T *rows = (const T *)rowsv; \
+    const T *d1 = (const T *)d1v; \
+    const T *d2 = (const T *)d2v; \
+    int numBestRows = 0; \
+    int minConflicts = INT_MAX; \
+    for (int base = 0; base < n; base += SCAN_BLOCK) { \
+        int end = base + SCAN_BLOCK < n ? base + SCAN_BLOCK : n; \
+        /*Pass 1: Block Minimum*/ \
+        __m512i vmin = SET1(MAXSUM); \
+        for (int row = base; row < end; row += (LANES)) { \
+            MASK_T live = end - row >= (LANES) ? (MASK_T)~(MASK_T)0 : (MASK_T)(((MASK_T)1 << (end - row)) - 1); \
+            __m512i sum = SUM(LOADZ(live, &rows[row]), SUM(LOADZ(live, &d1[row]), LOADZ(live, &d2[row]))); \
+            vmin = MASK_MIN(vmin, live, vmin, sum); \
+        } \
+        int blockMin = REDUCE(vmin); \
+        if (blockMin > minConflicts) { \
+            continue; \
+        } \
+        if (blockMin < minConflicts) { \
+            minConflicts = blockMin; \
+            numBestRows = 0; \
+        } \
+        /*Pass 2: Walk The Compare Mask*/ \
+        __m512i vbest = SET1(minConflicts); \
+        for (int row = base; row < end; row += (LANES)) { \
+            MASK_T live = end - row >= (LANES) ? (MASK_T)~(MASK_T)0 : (MASK_T)(((MASK_T)1 << (end - row)) - 1); \
+            __m512i sum = SUM(LOADZ(live, &rows[row]), SUM(LOADZ(live, &d1[row]), LOADZ(live, &d2[row]))); \
+            uint64_t tied = CMPEQ(live, sum, vbest); \
+            while (tied) { \
+                bestRows[numBestRows++] = row + __builtin_ctzll(tied); \
+                tied &= tied - 1; \
+            } \
+        } \
+    } \
+    return numBestRows; \
+}
+
+// Horizontal minimum of 64 unsigned bytes
+__attribute__((target("avx512f,avx512bw")))
+static inline int ReduceMinEpu8(__m512i v) {
+    __m256i h = _mm256_min_epu8(_mm512_castsi512_si256(v), _mm512_extracti64x4_epi64(v, 1));
+    return MinEpu8(_mm_min_epu8(_mm256_castsi256_si128(h), _mm256_extracti128_si256(h, 1)));
+}
+
+// Horizontal minimum of 32 unsigned words
+__attribute__((target("avx512f,avx512bw")))
+static inline int ReduceMinEpu16(__m512i v) {
+    __m256i h = _mm256_min_epu16(_mm512_castsi512_si256(v), _mm512_extracti64x4_epi64(v, 1));
+    return MinEpu16(_mm_min_epu16(_mm256_castsi256_si128(h), _mm256_extracti128_si256(h, 1)));
+}
+
+#define SET1_512_EPI8(x) _mm512_set1_epi8((char)(x))
+#define SET1_512_EPI16(x) _mm512_set1_epi16((short)(x))
+
+DEFINE_ROW_SCAN_AVX512BW(RowScanAVX512_8, uint8_t, UINT8_MAX, 64, __mmask64, _mm512_maskz_loadu_epi8,
+                         _mm512_adds_epu8, _mm512_mask_min_epu8, _mm512_mask_cmpeq_epi8_mask,
+                         SET1_512_EPI8, ReduceMinEpu8)
+DEFINE_ROW_SCAN_AVX512BW(RowScanAVX512_16, uint16_t, UINT16_MAX, 32, __mmask32, _mm512_maskz_loadu_epi16,
+                         _mm512_adds_epu16, _mm512_mask_min_epu16, _mm512_mask_cmpeq_epi16_mask,
+                         SET1_512_EPI16, ReduceMinEpu16)
+
+#endif
+
+// Kernels used by MinimizeConflicts indexed by ScanIndex(counterBytes),
+// chosen once by InitRowScan
+static RowScanFn RowScan[3] = {RowScanScalar8, RowScanScalar16, RowScanScalar32};
+static const char *RowScanName = "scalar";
+
+// Slot in RowScan for a counter width of 1, 2 or 4 bytes
+static inline int ScanIndex(int counterBytes) {
+    return counterBytes >> 1;
+}
+
+// Pick the widest row scan kernels this CPU supports
+static void InitRowScan(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+        RowScan[0] = RowScanAVX512_8;
+        RowScan[1] = RowScanAVX512_16;
+        RowScan[2] = RowScanAVX512_32;
+        RowScanName = "avx512";
+        return;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        RowScan[0] = RowScanAVX2_8;
+        RowScan[1] = RowScanAVX2_16;
+        RowScan[2] = RowScanAVX2_32;
+        RowScanName = "avx2";
+        return;
+    }
+#endif
+    RowScan[0] = RowScanScalar8;
+    RowScan[1] = RowScanScalar16;
+    RowScan[2] = RowScanScalar32;
+    RowScanName = "scalar";
+}
+
+#ifdef NQ_TELEMETRY
+// Hot-path counters of one worker, gathered into the trace and zeroed after
+// every step. Only compiled with -DNQ_TELEMETRY; otherwise TELEMETRY_ADD
+// expands to nothing
+typedef struct {
+    long scans;         // Full row scans
+    long ties;          // Best rows those scans found, summed
+    long moves;         // Conflicted queens that changed row
+    long noops;         // ... and those whose pick was the row they were on
+    double busy;        // Seconds inside step tasks
+    double taskStart;
+    int perfState;      // 0 not tried yet, 1 counting, -1 unavailable
+    int perfFds[3];     // Cycles (the group leader), LLC misses, branch misses
+    uint64_t perfStart[3];
+    uint64_t perf[3];   // Counted inside step tasks
+} Telemetry;
+#define TELEMETRY_ADD(ws, field, v) ((ws)->tm.field += (v))
+#else
+#define TELEMETRY_ADD(ws, field, v) ((void)0)
+#endif
+
+// Everything one worker needs during a solve. Leading with the aligned Rng
+// keeps each worker's block on its own cache lines
+typedef struct {
+    Rng rng;
+    Arena arena;
+    int *bestRows;      // n entries carved from arena at the start of each solve
+    uint64_t *lineBits; // Row then diagonal bitmaps for ValidateSolutionParallel
+    uint32_t *deltas;   // Bulk mode: this step's counter deltas grouped by owner
+    int *deltaEnd;      // Bulk mode: end of each owner's group in deltas
+    int16_t *ownLines;     // Bulk mode: this worker's moves this step per line,
+                           // rows then both diagonals, zero between steps
+    Deque deque;           // Async mode: conflicted columns waiting for a visit
+    int sampleRows;        // Rows sampled per move before a full scan, 0 for none
+    int missLimit;         // Misses in a row before sampling backs off
+    int misses;            // Current run of misses
+    int skipped;           // Moves since the last sample while backed off
+    _Alignas(64) atomic_long excess; // Async mode: this worker's share of the excess
+#ifdef NQ_TELEMETRY
+    Telemetry tm;
+#endif
+} WorkerScratch;
+
+// Find all rows with the minimum number of conflicts for col's queen,
+// leaving them in ws->bestRows and returning how many there are. The
+// counters are read without atomics, racing moves from other workers are
+// tolerated exactly as the per-element loads always did
+static inline int ScanBestRows(Board *b, int col, WorkerScratch *ws) {
+    int bytes = b->counterBytes;
+    return RowScan[ScanIndex(bytes)](b->rowConflicts.raw,
+                                     (const char *)b->diag1Conflicts.raw + (long)(b->n - col) * bytes,
+                                     (const char *)b->diag2Conflicts.raw + (long)col * bytes,
+                                     b->n, ws->bestRows);
+}
+
+// Try ws->sampleRows random rows for col's queen and return the first one
+// free on all three lines, or -1. A free row is always among the minimum
+// rows a full scan would find, so a hit is an ordinary min-conflicts move
+// at O(1) cost. own, if given, adds the bulk worker's pending moves. After
+// missLimit misses in a row free rows have grown scarce, so the worker backs
+// off to sampling only one move in missLimit until it gets a hit again
+static int SampleFreeRow(Board *b, int col, WorkerScratch *ws, const int16_t *own) {
+    if (ws->misses >= ws->missLimit) {
+        if (++ws->skipped < ws->missLimit) {
+            return -1;
+        }
+        ws->skipped = 0;
+    }
+    int n = b->n;
+    int current = b->queens[col];
+    for (int k = 0; k < ws->sampleRows; k++) {
+        int row = RandomBelow(&ws->rng, n);
+        if (row == current) {continue;}
+        int sum = GetCounter(b, b->rowConflicts, row) +
+                  GetCounter(b, b->diag1Conflicts, row - col + n) +
+                  GetCounter(b, b->diag2Conflicts, row + col);
+        if (own != NULL) {
+            sum += own[row] + own[n + row - col + n] + own[3 * n + row + col];
+        }
+        if (sum == 0) {
+            ws->misses = 0;
+            return row;
+        }
+    }
+    ws->misses++;
+    return -1;
+}
+
+// Pick the row col's queen should move to, or -1 if it has no conflict
+static inline int ChooseRow(Board *b, int col, WorkerScratch *ws) {
+
+    //If No Conflicts - Do Nothing
+    if (!HasConflict(b, col)) {
+        return -1;
+    }
+
+    //A Free Row From A Small Sample Saves The Full Scan
+    if (ws->sampleRows > 0) {
+        int row = SampleFreeRow(b, col, ws, NULL);
+        if (row >= 0) {
+            return row;
+        }
+    }
+
+    // Randomly select one of the best rows to diversify moves. The vector
+    // kernels read the counters twice, so a racing move between their passes
+    // can leave no tied row at all; the queen then stays where it is
+    int numBestRows = ScanBestRows(b, col, ws);
+    TELEMETRY_ADD(ws, scans, 1);
+    TELEMETRY_ADD(ws, ties, numBestRows);
+    if (numBestRows == 0) {
+        return b->queens[col];
+    }
+    return ws->bestRows[RandomBelow(&ws->rng, numBestRows)];
+}
+
+// Find Minimum Conflict Location for Queens in the given columns, recording
+// each column's move in moves[] and using the worker's rng and scratch
+static void MinimizeConflicts(Board *b, int *cols, MoveRecord *moves, int numCols, WorkerScratch *ws) {
+
+    //For every Row
+    for (int idx = 0; idx < numCols; idx++) {
+        int col = cols[idx];
+        moves[idx].fromRow = -1;
+        moves[idx].crossed = 0;
+
+        int newRow = ChooseRow(b, col, ws);
+        int oldRow = b->queens[col];
+        if (newRow >= 0 && newRow != oldRow) {
+            moves[idx].fromRow = oldRow;
+            moves[idx].crossed = UpdateQueen(b, col, newRow);
+            TELEMETRY_ADD(ws, moves, 1);
+        } else if (newRow >= 0) {
+            TELEMETRY_ADD(ws, noops, 1);
+        }
+    }
+}
+
+// Rank of a column for one bulk step, salt being drawn fresh every step
+static inline uint64_t StepRank(int col, uint64_t salt) {
+    uint64_t x = salt + (uint64_t)col;
+    return SplitMix64(&x);
+}
+
+// Moving off one snapshot, every queen of a conflicting line would jump at
+// once, often onto the same best row, so the conflict count stalls. A queen
+// sits the step out when it is outranked on all its conflicted lines. On a
+// line shared with exactly one other queen (named by the line XOR, exact
+// between steps) that means the partner ranks higher, so the top ranked
+// queen of such a cluster always moves. Crowded lines cannot name their
+// queens; each of those keeps about one mover by chance
+static int YieldsThisStep(const Board *b, int col, uint64_t salt) {
+    int n = b->n;
+    int row = b->queens[col];
+    long lines[3] = {row, row - col + n, row + col};
+    CounterArray counters[3] = {b->rowConflicts, b->diag1Conflicts, b->diag2Conflicts};
+    const int *xors[3] = {b->rowXor, b->diag1Xor, b->diag2Xor};
+    uint64_t mine = StepRank(col, salt);
+    for (int k = 0; k < 3; k++) {
+        int count = GetCounter(b, counters[k], lines[k]);
+        if (count < 2) {continue;}
+        if (count > 2) {
+            if ((mine >> 32) % count == 0) {return 0;}
+            continue;
+        }
+        int partner = (xors[k][lines[k]] ^ (col + 1)) - 1;
+        if (StepRank(partner, salt) < mine) {return 0;}
+    }
+    return 1;
+}
+
+// Count one of a worker's own moves on a line. The overlay only steers its
+// later picks within the step, so a line past the int16_t range simply
+// stays at the limit instead of wrapping
+static inline void BumpOwnLine(int16_t *own, int delta) {
+    int next = *own + delta;
+    if (next >= INT16_MIN && next <= INT16_MAX) {
+        *own = (int16_t)next;
+    }
+}
+
+// Bulk-synchronous MinimizeConflicts: every column is judged against the
+// counters as they stood at the start of the step, which nobody writes
+// until the step's barrier. Only queens[] changes here, each column having
+// a single owner; the counter deltas are logged by BucketDeltas. The CROSS_*
+// bits compare against that snapshot, which is all RefreshConflicts needs
+static void MinimizeConflictsSnapshot(Board *b, int *cols, MoveRecord *moves, int numCols, WorkerScratch *ws,
+                               uint64_t salt) {
+    int n = b->n;
+    int16_t *ownRow = ws->ownLines;
+    int16_t *ownDiag1 = ownRow + n;
+    int16_t *ownDiag2 = ownDiag1 + 2 * n;
+    for (int idx = 0; idx < numCols; idx++) {
+        int col = cols[idx];
+        moves[idx].fromRow = -1;
+        moves[idx].crossed = 0;
+
+        // This worker's own earlier moves may already have freed the queen
+        int row = b->queens[col];
+        if (GetCounter(b, b->rowConflicts, row) + ownRow[row] < 2 &&
+            GetCounter(b, b->diag1Conflicts, row - col + n) + ownDiag1[row - col + n] < 2 &&
+            GetCounter(b, b->diag2Conflicts, row + col) + ownDiag2[row + col] < 2) {
+            continue;
+        }
+        if (YieldsThisStep(b, col, salt)) {continue;}
+
+        // Best rows by the snapshot, preferring a random one this worker
+        // has not already moved a queen onto
+        int newRow = ws->sampleRows > 0 ? SampleFreeRow(b, col, ws, ws->ownLines) : -1;
+        if (newRow < 0) {
+            int numBestRows = ScanBestRows(b, col, ws);
+            TELEMETRY_ADD(ws, scans, 1);
+            TELEMETRY_ADD(ws, ties, numBestRows);
+            int pick = RandomBelow(&ws->rng, numBestRows);
+            newRow = ws->bestRows[pick];
+            for (int t = 0, i = pick; t < numBestRows; t++, i = i + 1 < numBestRows ? i + 1 : 0) {
+                int r = ws->bestRows[i];
+                if (ownRow[r] + ownDiag1[r - col + n] + ownDiag2[r + col] <= 0) {
+                    newRow = r;
+                    break;
+                }
+            }
+        }
+        int oldRow = row;
+        if (newRow == oldRow) {
+            TELEMETRY_ADD(ws, noops, 1);
+            continue;
+        }
+        TELEMETRY_ADD(ws, moves, 1);
+        int crossed = 0;
+        if (GetCounter(b, b->rowConflicts, oldRow) >= 2) {crossed |= CROSS_OLD_ROW;}
+        if (GetCounter(b, b->diag1Conflicts, oldRow - col + n) >= 2) {crossed |= CROSS_OLD_DIAG1;}
+        if (GetCounter(b, b->diag2Conflicts, oldRow + col) >= 2) {crossed |= CROSS_OLD_DIAG2;}
+        if (GetCounter(b, b->rowConflicts, newRow) <= 1) {crossed |= CROSS_NEW_ROW;}
+        if (GetCounter(b, b->diag1Conflicts, newRow - col + n) <= 1) {crossed |= CROSS_NEW_DIAG1;}
+        if (GetCounter(b, b->diag2Conflicts, newRow + col) <= 1) {crossed |= CROSS_NEW_DIAG2;}
+        b->queens[col] = newRow;
+        moves[idx].fromRow = oldRow;
+        moves[idx].crossed = crossed;
+        BumpOwnLine(&ownRow[oldRow], -1);
+        BumpOwnLine(&ownDiag1[oldRow - col + n], -1);
+        BumpOwnLine(&ownDiag2[oldRow + col], -1);
+        BumpOwnLine(&ownRow[newRow], 1);
+        BumpOwnLine(&ownDiag1[newRow - col + n], 1);
+        BumpOwnLine(&ownDiag2[newRow + col], 1);
+    }
+}
+
+// Zero the ownLines entries a worker's moves touched, ready for next step
+static void ClearOwnLines(const Board *b, const int *cols, const MoveRecord *moves, int numCols, WorkerScratch *ws) {
+    int n = b->n;
+    for (int idx = 0; idx < numCols; idx++) {
+        int oldRow = moves[idx].fromRow;
+        if (oldRow < 0) {continue;}
+        int col = cols[idx];
+        int newRow = b->queens[col];
+        ws->ownLines[oldRow] = ws->ownLines[newRow] = 0;
+        ws->ownLines[n + oldRow - col + n] = ws->ownLines[n + newRow - col + n] = 0;
+        ws->ownLines[3 * n + oldRow + col] = ws->ownLines[3 * n + newRow + col] = 0;
+    }
+}
+
+// The six counter deltas of one moved column
+static inline void MoveDeltas(const Board *b, int col, int oldRow, int newRow, uint32_t out[6]) {
+    int n = b->n;
+    out[0] = EncodeDelta(oldRow, DELTA_ROW, -1);
+    out[1] = EncodeDelta(oldRow - col + n, DELTA_DIAG1, -1);
+    out[2] = EncodeDelta(oldRow + col, DELTA_DIAG2, -1);
+    out[3] = EncodeDelta(newRow, DELTA_ROW, 1);
+    out[4] = EncodeDelta(newRow - col + n, DELTA_DIAG1, 1);
+    out[5] = EncodeDelta(newRow + col, DELTA_DIAG2, 1);
+}
+
+// Log the deltas of a worker's moves into ws->deltas, counting-sorted by
+// owning worker so each owner later reads one contiguous group per worker
+static void BucketDeltas(const Board *b, const int *cols, const MoveRecord *moves, int numCols,
+                  WorkerScratch *ws, int numWorkers) {
+    int *end = ws->deltaEnd;
+    memset(end, 0, (numWorkers + 1) * sizeof(int));
+    uint32_t entry[6];
+
+    //Count Entries Per Owner, Shifted Up One Slot
+    for (int idx = 0; idx < numCols; idx++) {
+        if (moves[idx].fromRow < 0) {continue;}
+        MoveDeltas(b, cols[idx], moves[idx].fromRow, b->queens[cols[idx]], entry);
+        for (int k = 0; k < 6; k++) {
+            end[DeltaOwner(b, entry[k], numWorkers) + 1]++;
+        }
+    }
+    //Prefix Sum Gives Each Group's Start
+    for (int w = 1; w <= numWorkers; w++) {
+        end[w] += end[w - 1];
+    }
+    //Scatter; Each Start Advances To Its Group's End
+    for (int idx = 0; idx < numCols; idx++) {
+        if (moves[idx].fromRow < 0) {continue;}
+        MoveDeltas(b, cols[idx], moves[idx].fromRow, b->queens[cols[idx]], entry);
+        for (int k = 0; k < 6; k++) {
+            ws->deltas[end[DeltaOwner(b, entry[k], numWorkers)]++] = entry[k];
+        }
+    }
+}
+
+
+// Mark every row and diagonal used by the queens in columns [from, to) in
+// the three bitmaps. Returns 0 on a row out of range or a line claimed twice
+static int ClaimLines(const int *queens, int from, int to, int n,
+                      uint64_t *rows, uint64_t *diag1, uint64_t *diag2) {
+    for (int col = from; col < to; col++) {
+        int row = queens[col];
+        //Check Values Within Range
+        if (row >= n || row < 0) {
+            return 0;
+        }
+        unsigned d1 = row - col + n;
+        unsigned d2 = row + col;
+        uint64_t rbit = 1ull << (row & 63), d1bit = 1ull << (d1 & 63), d2bit = 1ull << (d2 & 63);
+        if ((rows[row >> 6] & rbit) | (diag1[d1 >> 6] & d1bit) | (diag2[d2 >> 6] & d2bit)) {
+            return 0;
+        }
+        rows[row >> 6] |= rbit;
+        diag1[d1 >> 6] |= d1bit;
+        diag2[d2 >> 6] |= d2bit;
+    }
+    return 1;
+}
+
+// 64-bit words in the row bitmap and in each diagonal bitmap for size n
+static size_t RowWords(int n) {return ((size_t)n + 63) / 64;}
+static size_t DiagWords(int n) {return (2 * (size_t)n + 63) / 64;}
+
+// Validate if the solution is valid (no queens attack each other) in O(n)
+// by letting each queen claim its row and both diagonals. -1 if the line
+// bitmaps cannot be allocated
+int ValidateSolution(const int *queens, int n) {
+    uint64_t *bits = (uint64_t *)calloc(RowWords(n) + 2 * DiagWords(n), sizeof(uint64_t));
+    if (bits == NULL) {
+        return -1;
+    }
+    int ok = ClaimLines(queens, 0, n, n, bits, bits + RowWords(n), bits + RowWords(n) + DiagWords(n));
+    free(bits);
+    return ok;
+}
+
+// Original O(n^2) pairwise check, kept as an opt-in cross-check
+int ValidateSolutionPairwise(const int *queens, int n) {
+    for (int i = 0; i < n; i++) {
+        //Check Values Within Range
+        if ((queens[i] >= n) || (queens[i] < 0)){
+            return 0;
+        }
+        for (int j = i + 1; j < n; j++) {
+            // Check row conflicts
+            if (queens[i] == queens[j]) {
+                return 0; // false
+            }
+            // Check diagonal conflicts
+            if (abs_int(i - j) == abs_int(queens[i] - queens[j])) {
+                return 0; // false
+            }
+        }
+    }
+    return 1; // true
+}
+
+// Work shared by the pool for one step of SolveParallel
+typedef struct {
+    Board *board;
+    int *cols;
+    MoveRecord *moves;
+    WorkerScratch *workers;
+    int numCols;
+    int chunkSize;
+    const int *chunkStart; // Locality: worker k takes cols[chunkStart[k], chunkStart[k + 1]),
+                           // NULL for chunks of chunkSize
+    int numWorkers;
+    uint64_t salt; // Bulk mode: ranks columns for YieldsThisStep
+    const struct SolverContext *ctx; // For StopRequested part way through a step
+} StepData;
+
+// Checkpoint file layout: this header on its own page, the queens from the
+// next page on, then the row, diag1 and diag2 counters counterBytes wide,
+// page aligned. The counters only keep the board off the heap; a resume
+// rebuilds them from the queens. Native byte order; a file only resumes on
+// the machine kind that wrote it
+#define CHECKPOINT_MAGIC "NQCKPT2"
+#define CHECKPOINT_PAGE 4096
+
+// Worker streams the header page has room for; a larger pool saves none
+#define CHECKPOINT_MAX_STREAMS 120
+
+typedef struct {
+    char magic[8];
+    int n;
+    int counterBytes;   // Width of the counters in the file, 0 when it holds none
+    int step;           // Steps done at the last flush
+    int numStreams;     // Worker streams saved below, 0 if the pool had too many
+    uint64_t seed;      // Seed of the solve the file belongs to
+    uint64_t rng[4];    // Context rng at the last flush
+    uint64_t streams[CHECKPOINT_MAX_STREAMS][4]; // ... and every worker's
+} CheckpointHeader;
+
+// The checkpoint file of the running solve, mapped shared
+typedef struct {
+    int fd;
+    char *map;                // NULL when no file is open
+    size_t size;
+    CheckpointHeader *header; // Start of map
+    double nextFlush;         // NowSeconds() time of the next periodic flush
+} Checkpoint;
+
+// SolverContext owns everything a solve allocates: the board, the step
+// buffers and one scratch block per pool worker. It is created once and
+// reused by every run, so buffers are only allocated when n grows
+typedef struct SolverContext {
+    WorkerPool *pool;
+    int capacity;           // Largest n the step buffers are sized for
+    Board *board;
+    int *conflictCols;
+    MoveRecord *moves;
+    atomic_uchar *queued;   // Async mode: column sits in some deque
+    WorkerScratch *workers; // pool->numWorkers entries
+    Rng rng;                // Setup and shuffling
+    InitMethod init;
+    Engine engine;
+    int constructSymmetry;  // Construct engine: apply a random board symmetry
+    int splitDepth;         // Count engine: rows fixed per parallel task, 0 for auto
+    StepMode stepMode;      // How min-conflicts steps run on the pool
+    int sampleRows;         // Move policy: rows sampled before a full scan, 0 for none,
+                            // SAMPLE_AUTO for SAMPLE_AUTO_ROWS on large boards
+    int sampleMisses;       // Failed samples in a row before a worker backs off
+    int stallWindow;        // Steps without a new fewest conflicts before a perturbation, 0 never
+    int crossCheck;         // Also run the O(n^2) validator after each solve
+    atomic_int *cancel;     // Portfolio: set by the first member to solve, NULL if alone
+    atomic_int *stop;       // Caller's flag: stop and return the current board, NULL for none
+    double deadline;        // Seconds a solve may take before it returns its best board, 0 for none
+    double stopAt;          // ... as a NowSeconds() time, set per solve
+    double solveStart;
+    int outOfMemory;        // A buffer could not be grown mid-solve, which ends it
+    ProgressCallback progress; // NULL for none
+    void *progressArg;
+    int progressEvery;      // Steps between progress calls
+    int *bestQueens;        // With a deadline: the board with the fewest conflicts so far
+    int bestCapacity;
+    int bestConflicts;
+    int locality;           // Workers keep to their own column blocks and pages
+    int localityShift;      // ... whose boundaries move by this many columns
+    int *chunkStart;        // ... numWorkers + 1 block starts, then as many cursors
+    const char *checkpointPath; // File the min-conflicts board lives in, NULL for none
+    double checkpointEvery; // Seconds between flushes
+    Checkpoint checkpoint;
+#ifdef NQ_TELEMETRY
+    FILE *trace;            // Per-step trace lines, NULL for none
+    int tracePerf;          // Also count cycles and misses with perf_event_open
+    int traceRun;           // Run column of the trace, counts this context's solves
+#endif
+} SolverContext;
+
+// True once the solve should give up: another portfolio member won, the
+// caller raised its stop flag or the deadline passed. Relaxed loads and a
+// vDSO clock read, cheap enough for every step
+static inline int StopRequested(const SolverContext *ctx) {
+    return (ctx->cancel != NULL && atomic_load_explicit(ctx->cancel, memory_order_relaxed)) ||
+           (ctx->stop != NULL && atomic_load_explicit(ctx->stop, memory_order_relaxed)) ||
+           (ctx->stopAt > 0 && NowSeconds() >= ctx->stopAt);
+}
+
+// Create a context that runs its steps on pool, NULL if out of memory
+static SolverContext *NewSolverContext(WorkerPool *pool) {
+    SolverContext *ctx = (SolverContext *)aligned_alloc(_Alignof(SolverContext), sizeof(SolverContext));
+    if (ctx == NULL) {
+        return NULL;
+    }
+    memset(ctx, 0, sizeof(SolverContext));
+    ctx->pool = pool;
+    ctx->workers = (WorkerScratch *)aligned_alloc(_Alignof(WorkerScratch),
+                                                 pool->numWorkers * sizeof(WorkerScratch));
+    ctx->chunkStart = (int *)malloc(2 * (pool->numWorkers + 1) * sizeof(int));
+    if (ctx->workers == NULL || ctx->chunkStart == NULL) {
+        free(ctx->workers);
+        free(ctx->chunkStart);
+        free(ctx);
+        return NULL;
+    }
+    memset(ctx->workers, 0, pool->numWorkers * sizeof(WorkerScratch));
+    return ctx;
+}
+
+// Random rows tried per queen by the greedy initializer before it settles
+// for a conflicted one
+#define GREEDY_TRIES 8
+
+// Boards from this size up are placed by every worker of the pool
+#define PARALLEL_INIT_MIN_N (1 << 16)
+
+// Shared state of one PlaceQueens call. Columns are split into numBlocks
+// contiguous blocks and the rows the same way, one of each per worker. On
+// several blocks a permutation start first shuffles all rows in parallel:
+// each worker sends every row of its row block to a random bucket, the
+// buckets are laid out one after another in queens and each is shuffled on
+// its own (Rao-Sandelius), and column block k then takes its rows from its
+// own stretch of that permutation
+typedef struct {
+    Board *board;
+    InitMethod method;
+    WorkerScratch *workers;
+    int numBlocks;
+    int *slots;       // Row block w's count for bucket k at [w * numBlocks + k], then its next slot in queens
+    int *bucketStart; // numBlocks + 1 starts of the buckets in queens
+    Rng *draws;       // Each worker's rng before it drew its buckets, to draw them again
+} PlaceData;
+
+// First index of block k when n items are split into numBlocks blocks, the
+// first n % numBlocks of them one longer
+static inline int BlockStart(int n, int numBlocks, int k) {
+    int q = n / numBlocks, r = n % numBlocks;
+    return k * q + (k < r ? k : r);
+}
+
+// Block of the split above that index i falls in
+static inline int BlockOf(int n, int numBlocks, int i) {
+    int q = n / numBlocks, r = n % numBlocks;
+    int longPart = r * (q + 1);
+    return i < longPart ? i / (q + 1) : r + (i - longPart) / q;
+}
+
+// Hand the whole pages inside [p, p + bytes) back to the kernel, so the
+// next write faults them in afresh on the writer's node. Only for heap
+// memory that is about to be zeroed anyway
+static void ReleasePages(void *p, size_t bytes) {
+    const uintptr_t page = 4096;
+    uintptr_t from = ((uintptr_t)p + page - 1) & ~(page - 1);
+    uintptr_t to = ((uintptr_t)p + bytes) & ~(page - 1);
+    if (to > from) {
+        madvise((void *)from, to - from, MADV_DONTNEED);
+    }
+}
+
+// Pool task for locality mode, in place of ResetBoard's memsets: zero one
+// block of each line's XORs and counters and empty one block of columns, so
+// a page is first touched, and placed in memory, by the worker that uses it.
+// A reused board's pages were placed for the last solve's blocks, so the
+// worker releases its blocks' pages first and the zeroing places them anew.
+// Only the column arrays stay with their worker; rows and diagonals are
+// shared by every column and are just spread across the workers' memory
+static void ClearBoardTask(void *arg, int worker) {
+    SolverContext *ctx = (SolverContext *)arg;
+    Board *b = ctx->board;
+    int n = b->n, numWorkers = ctx->pool->numWorkers;
+    size_t bytes = b->counterBytes;
+
+    int from = BlockStart(n, numWorkers, worker), to = BlockStart(n, numWorkers, worker + 1);
+    ReleasePages(&b->rowXor[from], (to - from) * sizeof(int));
+    ReleasePages((char *)b->rowConflicts.raw + from * bytes, (to - from) * bytes);
+    ReleasePages(&b->queens[from], (to - from) * sizeof(int));
+    ReleasePages(&b->conflictIndex[from], (to - from) * sizeof(int));
+    memset(&b->rowXor[from], 0, (to - from) * sizeof(int));
+    memset((char *)b->rowConflicts.raw + from * bytes, 0, (to - from) * bytes);
+    for (int col = from; col < to; col++) {
+        b->queens[col] = 0;
+        b->conflictIndex[col] = -1;
+    }
+
+    from = BlockStart(2 * n, numWorkers, worker), to = BlockStart(2 * n, numWorkers, worker + 1);
+    ReleasePages(&b->diag1Xor[from], (to - from) * sizeof(int));
+    ReleasePages(&b->diag2Xor[from], (to - from) * sizeof(int));
+    ReleasePages((char *)b->diag1Conflicts.raw + from * bytes, (to - from) * bytes);
+    ReleasePages((char *)b->diag2Conflicts.raw + from * bytes, (to - from) * bytes);
+    memset(&b->diag1Xor[from], 0, (to - from) * sizeof(int));
+    memset(&b->diag2Xor[from], 0, (to - from) * sizeof(int));
+    memset((char *)b->diag1Conflicts.raw + from * bytes, 0, (to - from) * bytes);
+    memset((char *)b->diag2Conflicts.raw + from * bytes, 0, (to - from) * bytes);
+}
+
+// Put col's queen on row, counting it on its three lines
+static inline void PlaceQueen(Board *b, int col, int row) {
+    int n = b->n;
+    b->queens[col] = row;
+    AddCounter(b, b->rowConflicts, row, 1);
+    AddCounter(b, b->diag1Conflicts, row - col + n, 1);
+    AddCounter(b, b->diag2Conflicts, row + col, 1);
+    FlipLineXor(b->rowXor, row, col);
+    FlipLineXor(b->diag1Xor, row - col + n, col);
+    FlipLineXor(b->diag2Xor, row + col, col);
+}
+
+// Pool task: place the queens of one column block with the worker's rng.
+// Blocks only share counters and XORs, which are updated atomically
+static void PlaceQueensTask(void *arg, int worker) {
+    PlaceData *p = (PlaceData *)arg;
+    if (worker >= p->numBlocks) {
+        return;
+    }
+    Board *b = p->board;
+    Rng *rng = &p->workers[worker].rng;
+    int n = b->n;
+    int c0 = BlockStart(n, p->numBlocks, worker);
+    int m = BlockStart(n, p->numBlocks, worker + 1) - c0;
+
+    if (p->method == INIT_RANDOM) {
+        for (int col = c0; col < c0 + m; col++) {
+            PlaceQueen(b, col, RandomBelow(rng, n));
+        }
+        return;
+    }
+
+    //The Block's Own Queens Hold Its Unused Rows Until They Are Placed; On
+    //Several Blocks The Shuffle Has Already Put Them There
+    int *rows = &b->queens[c0];
+    if (p->numBlocks == 1) {
+        for (int k = 0; k < m; k++) {
+            rows[k] = k;
+        }
+    }
+    for (int k = 0; k < m; k++) {
+        int col = c0 + k;
+        int pick = k + RandomBelow(rng, m - k);
+        if (p->method == INIT_GREEDY) {
+            for (int t = 1; t < GREEDY_TRIES; t++) {
+                int row = rows[pick];
+                if (GetCounter(b, b->diag1Conflicts, row - col + n) == 0 &&
+                    GetCounter(b, b->diag2Conflicts, row + col) == 0) {
+                    break;
+                }
+                pick = k + RandomBelow(rng, m - k);
+            }
+        }
+        int row = rows[pick];
+        rows[pick] = rows[k];
+        PlaceQueen(b, col, row);
+    }
+}
+
+// Pool task: draw a bucket for every row of the worker's row block and
+// count them
+static void CountBucketsTask(void *arg, int worker) {
+    PlaceData *p = (PlaceData *)arg;
+    Rng *rng = &p->workers[worker].rng;
+    int n = p->board->n;
+    int *slots = &p->slots[(size_t)worker * p->numBlocks];
+    p->draws[worker] = *rng;
+    memset(slots, 0, p->numBlocks * sizeof(int));
+    int to = BlockStart(n, p->numBlocks, worker + 1);
+    for (int row = BlockStart(n, p->numBlocks, worker); row < to; row++) {
+        slots[RandomBelow(rng, p->numBlocks)]++;
+    }
+}
+
+// Pool task: draw the same buckets again and write every row of the
+// worker's row block to the next slot of its bucket
+static void ScatterRowsTask(void *arg, int worker) {
+    PlaceData *p = (PlaceData *)arg;
+    Rng rng = p->draws[worker];
+    int n = p->board->n;
+    int *slots = &p->slots[(size_t)worker * p->numBlocks];
+    int to = BlockStart(n, p->numBlocks, worker + 1);
+    for (int row = BlockStart(n, p->numBlocks, worker); row < to; row++) {
+        p->board->queens[slots[RandomBelow(&rng, p->numBlocks)]++] = row;
+    }
+}
+
+// Pool task: shuffle the worker's bucket in place
+static void ShuffleBucketTask(void *arg, int worker) {
+    PlaceData *p = (PlaceData *)arg;
+    Rng *rng = &p->workers[worker].rng;
+    int *rows = &p->board->queens[p->bucketStart[worker]];
+    int count = p->bucketStart[worker + 1] - p->bucketStart[worker];
+    for (int i = count - 1; i > 0; i--) {
+        int j = RandomBelow(rng, i + 1);
+        int temp = rows[i];
+        rows[i] = rows[j];
+        rows[j] = temp;
+    }
+}
+
+// Place the queens of a reset board with the given method, on every worker
+// for large boards. Returns 0 if out of memory
+static int PlaceQueens(SolverContext *ctx, InitMethod method) {
+    Board *b = ctx->board;
+    PlaceData p;
+    p.board = b;
+    p.method = method;
+    p.workers = ctx->workers;
+    p.numBlocks = b->n >= PARALLEL_INIT_MIN_N ? ctx->pool->numWorkers : 1;
+
+    if (method != INIT_RANDOM && p.numBlocks > 1) {
+        int k = p.numBlocks;
+        p.slots = (int *)malloc(((size_t)k * k + k + 1) * sizeof(int));
+        p.draws = (Rng *)aligned_alloc(_Alignof(Rng), k * sizeof(Rng));
+        if (p.slots == NULL || p.draws == NULL) {
+            free(p.slots);
+            free(p.draws);
+            return 0;
+        }
+        p.bucketStart = p.slots + (size_t)k * k;
+        RunWorkerPool(ctx->pool, CountBucketsTask, &p);
+
+        //Buckets In Order, Each Filled By The Row Blocks In Order
+        int next = 0;
+        for (int bucket = 0; bucket < k; bucket++) {
+            p.bucketStart[bucket] = next;
+            for (int w = 0; w < k; w++) {
+                int count = p.slots[(size_t)w * k + bucket];
+                p.slots[(size_t)w * k + bucket] = next;
+                next += count;
+            }
+        }
+        p.bucketStart[k] = next;
+        RunWorkerPool(ctx->pool, ScatterRowsTask, &p);
+        RunWorkerPool(ctx->pool, ShuffleBucketTask, &p);
+        free(p.slots);
+        free(p.draws);
+    }
+    RunWorkerPool(ctx->pool, PlaceQueensTask, &p);
+    return FinishPlacement(b);
+}
+
+static size_t PageAlign(size_t bytes) {
+    return (bytes + CHECKPOINT_PAGE - 1) & ~(size_t)(CHECKPOINT_PAGE - 1);
+}
+
+// Offset of the counters in a checkpoint file for n, and its full size
+static size_t CheckpointCountersAt(int n) {
+    return CHECKPOINT_PAGE + PageAlign((size_t)n * sizeof(int));
+}
+
+static size_t CheckpointSize(int n, int counterBytes) {
+    return CheckpointCountersAt(n) + 5 * (size_t)n * counterBytes;
+}
+
+// PrepareSolverContext's result when a buffer for n cannot be allocated
+#define PREPARE_NO_MEMORY -2
+
+// Shared state of one RecountBoard call
+typedef struct {
+    Board *board;
+    int numBlocks;
+    atomic_int bad; // Some queen sits off the board
+} RecountData;
+
+// Pool task: zero one block of each counter array
+static void ClearCountersTask(void *arg, int worker) {
+    RecountData *r = (RecountData *)arg;
+    Board *b = r->board;
+    size_t bytes = b->counterBytes;
+    CounterArray lines[3] = {b->rowConflicts, b->diag1Conflicts, b->diag2Conflicts};
+    for (int k = 0; k < 3; k++) {
+        int len = k ? 2 * b->n : b->n;
+        int from = BlockStart(len, r->numBlocks, worker), to = BlockStart(len, r->numBlocks, worker + 1);
+        memset((char *)lines[k].raw + from * bytes, 0, (to - from) * bytes);
+    }
+}
+
+// Pool task: count one column block's queens on their lines
+static void RecountTask(void *arg, int worker) {
+    RecountData *r = (RecountData *)arg;
+    Board *b = r->board;
+    int n = b->n;
+    int to = BlockStart(n, r->numBlocks, worker + 1);
+    for (int col = BlockStart(n, r->numBlocks, worker); col < to; col++) {
+        int row = b->queens[col];
+        if (row < 0 || row >= n) {
+            atomic_store(&r->bad, 1);
+            return;
+        }
+        AddCounter(b, b->rowConflicts, row, 1);
+        AddCounter(b, b->diag1Conflicts, row - col + n, 1);
+        AddCounter(b, b->diag2Conflicts, row + col, 1);
+        FlipLineXor(b->rowXor, row, col);
+        FlipLineXor(b->diag1Xor, row - col + n, col);
+        FlipLineXor(b->diag2Xor, row + col, col);
+    }
+}
+
+// Settle a board whose queens came from a file on every worker: its XORs
+// and counters are rebuilt from the queens, whatever the file's counters
+// hold. Returns 1, 0 if a queen is off the board, or PREPARE_NO_MEMORY if
+// the counters had to be widened and could not be
+static int RecountBoard(SolverContext *ctx) {
+    RecountData r;
+    r.board = ctx->board;
+    r.numBlocks = ctx->pool->numWorkers;
+    atomic_store(&r.bad, 0);
+    RunWorkerPool(ctx->pool, ClearCountersTask, &r);
+    RunWorkerPool(ctx->pool, RecountTask, &r);
+    if (atomic_load(&r.bad)) {
+        return 0;
+    }
+    return FinishPlacement(ctx->board) ? 1 : PREPARE_NO_MEMORY;
+}
+
+// Hand the board of the last checkpointed solve back to the heap and close
+// its file. The next ResetBoard allocates fresh arrays
+static void CloseCheckpoint(SolverContext *ctx) {
+    Checkpoint *cp = &ctx->checkpoint;
+    if (cp->map == NULL) {
+        return;
+    }
+    Board *b = ctx->board;
+    b->queens = NULL;
+    b->queensCapacity = 0;
+    if (b->countersMapped) {
+        b->rowConflicts.raw = b->diag1Conflicts.raw = b->diag2Conflicts.raw = NULL;
+        b->countersMapped = 0;
+    }
+    munmap(cp->map, cp->size);
+    close(cp->fd);
+    cp->map = NULL;
+    cp->header = NULL;
+}
+
+// Give every worker its own stream split off seed, and the context the next
+static void SplitRng(SolverContext *ctx, uint64_t seed) {
+    Rng stream;
+    SeedRng(&stream, seed);
+    for (int w = 0; w < ctx->pool->numWorkers; w++) {
+        ctx->workers[w].rng = stream;
+        JumpRng(&stream);
+    }
+    ctx->rng = stream;
+}
+
+// Write the board out at a step boundary: the queens first, then the header.
+// step and the context and worker rngs let a resumed solve carry on
+// counting and drawing where this one was. The counters are not written
+// back, since a resume never reads them
+static void FlushCheckpoint(SolverContext *ctx, int step) {
+    Checkpoint *cp = &ctx->checkpoint;
+    CheckpointHeader *h = cp->header;
+    Board *b = ctx->board;
+    int numWorkers = ctx->pool->numWorkers;
+    h->step = step;
+    memcpy(h->rng, ctx->rng.s, sizeof(h->rng));
+    h->numStreams = numWorkers <= CHECKPOINT_MAX_STREAMS ? numWorkers : 0;
+    for (int w = 0; w < h->numStreams; w++) {
+        memcpy(h->streams[w], ctx->workers[w].rng.s, sizeof(h->streams[w]));
+    }
+    h->counterBytes = b->countersMapped ? b->counterBytes : 0;
+    msync(cp->map + CHECKPOINT_PAGE, CheckpointCountersAt(b->n) - CHECKPOINT_PAGE, MS_SYNC);
+    msync(cp->map, CHECKPOINT_PAGE, MS_SYNC);
+    cp->nextFlush = NowSeconds() + ctx->checkpointEvery;
+}
+
+// Open the checkpoint file for a reset n-queens board and move the board's
+// queens and counters into it. A file already holding a board for n is
+// resumed: its queens are kept, everything else rebuilt from them on the
+// pool, and the step count and rngs restored. Returns 1 when resumed, 0 for a fresh zeroed board still to be
+// placed, -1 if the file cannot be opened or mapped, PREPARE_NO_MEMORY if
+// the board cannot be settled
+static int OpenCheckpoint(SolverContext *ctx, int n, uint64_t seed) {
+    Checkpoint *cp = &ctx->checkpoint;
+    Board *b = ctx->board;
+    int fd = open(ctx->checkpointPath, O_RDWR | O_CREAT, 0644);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        if (fd >= 0) {close(fd);}
+        return -1;
+    }
+
+    //A File For This n Is Resumed; Its Counters Are Mapped Only If All Their Pages Are There
+    CheckpointHeader h;
+    int resume = (size_t)st.st_size >= CheckpointCountersAt(n) &&
+                 pread(fd, &h, sizeof(h), 0) == (ssize_t)sizeof(h) &&
+                 memcmp(h.magic, CHECKPOINT_MAGIC, sizeof(h.magic)) == 0 && h.n == n;
+    int counterBytes = b->counterBytes;
+    if (resume) {
+        counterBytes = h.counterBytes;
+        if ((counterBytes != 1 && counterBytes != 2 && counterBytes != 4) ||
+            (size_t)st.st_size < CheckpointSize(n, counterBytes)) {
+            counterBytes = 0;
+        }
+    }
+    size_t size = CheckpointSize(n, counterBytes);
+    if (!resume && (ftruncate(fd, 0) != 0 || ftruncate(fd, size) != 0)) {
+        close(fd);
+        return -1;
+    }
+    char *map = (char *)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        close(fd);
+        return -1;
+    }
+    cp->fd = fd;
+    cp->map = map;
+    cp->size = size;
+    cp->header = (CheckpointHeader *)map;
+    cp->nextFlush = NowSeconds() + ctx->checkpointEvery;
+
+    //The Heap Arrays ResetBoard Left Give Way To The File's
+    free(b->queens);
+    b->queens = (int *)(map + CHECKPOINT_PAGE);
+    b->queensCapacity = n;
+    if (counterBytes) {
+        free(b->rowConflicts.raw);
+        free(b->diag1Conflicts.raw);
+        free(b->diag2Conflicts.raw);
+        char *c = map + CheckpointCountersAt(n);
+        b->rowConflicts.raw = c;
+        b->diag1Conflicts.raw = c + (size_t)n * counterBytes;
+        b->diag2Conflicts.raw = c + (size_t)3 * n * counterBytes;
+        b->counterBytes = counterBytes;
+        b->counterLimit = CounterLimit(counterBytes);
+        b->countersMapped = 1;
+    }
+
+    int recounted = resume ? RecountBoard(ctx) : 0;
+    if (recounted == PREPARE_NO_MEMORY) {
+        return PREPARE_NO_MEMORY;
+    }
+    if (recounted) {
+        //Draw On From The Last Flush; On Another Thread Count The File's Seed Is Split Afresh
+        if (h.numStreams == ctx->pool->numWorkers) {
+            for (int w = 0; w < h.numStreams; w++) {
+                memcpy(ctx->workers[w].rng.s, h.streams[w], sizeof(h.streams[w]));
+            }
+        } else {
+            SplitRng(ctx, h.seed);
+        }
+        memcpy(ctx->rng.s, h.rng, sizeof(h.rng));
+        return 1;
+    }
+
+    //Fresh Or Unusable: A Zeroed Board Under A New Header
+    if (resume && !ResetBoard(b, n)) {
+        return PREPARE_NO_MEMORY;
+    }
+    CheckpointHeader *fresh = cp->header;
+    memset(fresh, 0, sizeof(*fresh));
+    memcpy(fresh->magic, CHECKPOINT_MAGIC, sizeof(fresh->magic));
+    fresh->n = n;
+    fresh->counterBytes = b->countersMapped ? b->counterBytes : 0;
+    fresh->seed = seed;
+    return 0;
+}
+
+// Size the context for an n-queens solve and split seed into one stream per
+// worker plus the context's own. Returns 1 if the board was resumed from the
+// checkpoint file, -1 if that file cannot be used, PREPARE_NO_MEMORY, else 0
+static int PrepareSolverContext(SolverContext *ctx, int n, uint64_t seed) {
+
+    //The Last Solve's Checkpoint Board Goes Back To The Heap
+    CloseCheckpoint(ctx);
+
+    //A Constructed Board Needs Only Its Queens And The Validation Bitmaps
+    int construct = ctx->engine == ENGINE_CONSTRUCT;
+    if (!construct && n > ctx->capacity) {
+        free(ctx->conflictCols);
+        free(ctx->moves);
+        free(ctx->queued);
+        ctx->conflictCols = (int *)malloc(n * sizeof(int));
+        ctx->moves = (MoveRecord *)malloc(n * sizeof(MoveRecord));
+        ctx->queued = (atomic_uchar *)malloc(n * sizeof(atomic_uchar));
+        ctx->capacity = n;
+        if (ctx->conflictCols == NULL || ctx->moves == NULL || ctx->queued == NULL) {
+            ctx->capacity = 0;
+            return PREPARE_NO_MEMORY;
+        }
+    }
+
+    //Bulk Mode Logs Up To Six Deltas For Each Column Of A Worker's Chunk
+    int numWorkers = ctx->pool->numWorkers;
+    size_t deltaBytes = 0, endBytes = 0, ownBytes = 0;
+    if (ctx->stepMode == STEP_BULK) {
+        deltaBytes = 6 * (size_t)((n + numWorkers - 1) / numWorkers) * sizeof(uint32_t);
+        endBytes = (numWorkers + 1) * sizeof(int);
+        ownBytes = 5 * (size_t)n * sizeof(int16_t);
+    }
+    //Async Mode Gives Every Worker A Deque Big Enough For All Columns
+    size_t dequeBytes = 0;
+    long dequeMask = 0;
+    if (ctx->stepMode == STEP_ASYNC) {
+        while (dequeMask + 1 < n) {
+            dequeMask = 2 * dequeMask + 1;
+        }
+        dequeBytes = (dequeMask + 1) * sizeof(atomic_int);
+    }
+
+    for (int w = 0; w < numWorkers; w++) {
+        WorkerScratch *ws = &ctx->workers[w];
+        size_t bitBytes = (RowWords(n) + 2 * DiagWords(n)) * sizeof(uint64_t);
+        size_t bestBytes = construct ? 0 : n * sizeof(int);
+        if (!ArenaReserve(&ws->arena, bestBytes + bitBytes + deltaBytes + endBytes + ownBytes + dequeBytes + 384)) {
+            return PREPARE_NO_MEMORY;
+        }
+        ws->bestRows = (int *)ArenaAlloc(&ws->arena, bestBytes);
+        ws->lineBits = (uint64_t *)ArenaAlloc(&ws->arena, bitBytes);
+        ws->deltas = deltaBytes ? (uint32_t *)ArenaAlloc(&ws->arena, deltaBytes) : NULL;
+        ws->deltaEnd = endBytes ? (int *)ArenaAlloc(&ws->arena, endBytes) : NULL;
+        ws->ownLines = ownBytes ? (int16_t *)ArenaAlloc(&ws->arena, ownBytes) : NULL;
+        if (ownBytes) {
+            memset(ws->ownLines, 0, ownBytes);
+        }
+        ResetDeque(&ws->deque, dequeBytes ? (atomic_int *)ArenaAlloc(&ws->arena, dequeBytes) : NULL, dequeMask);
+        ws->sampleRows = ctx->sampleRows != SAMPLE_AUTO ? ctx->sampleRows : n >= SAMPLE_AUTO_MIN_N ? SAMPLE_AUTO_ROWS : 0;
+        ws->missLimit = ctx->sampleMisses;
+        ws->misses = 0;
+        ws->skipped = 0;
+    }
+    SplitRng(ctx, seed);
+
+    if (ctx->board == NULL) {
+        ctx->board = (Board *)calloc(1, sizeof(Board));
+        if (ctx->board == NULL) {
+            return PREPARE_NO_MEMORY;
+        }
+    }
+    if (construct) {
+        if (!ResizeQueens(ctx->board, n)) {
+            return PREPARE_NO_MEMORY;
+        }
+        ctx->board->n = n;
+        ctx->board->numConflicts = 0;
+        return 0;
+    }
+    ctx->board->deferClear = ctx->locality;
+    int reset = ResetBoard(ctx->board, n);
+    ctx->board->deferClear = 0;
+    if (!reset) {
+        return PREPARE_NO_MEMORY;
+    }
+    if (ctx->locality) {
+        RunWorkerPool(ctx->pool, ClearBoardTask, ctx);
+    }
+
+    //The Swap Engine Needs A Permutation To Start From
+    InitMethod init = ctx->init;
+    if (ctx->engine == ENGINE_SWAP && init == INIT_RANDOM) {
+        init = INIT_PERMUTATION;
+    }
+
+    //Min-Conflicts Steps Can Keep Their Board In A File And Pick It Up Again
+    if (ctx->checkpointPath != NULL && ctx->engine == ENGINE_MIN_CONFLICTS && ctx->stepMode != STEP_ASYNC) {
+        int opened = OpenCheckpoint(ctx, n, seed);
+        if (opened != 0) {
+            return opened;
+        }
+    }
+    return PlaceQueens(ctx, init) ? 0 : PREPARE_NO_MEMORY;
+}
+
+// Kick a stalled board: half the conflicted queens, at least one, jump to
+// uniformly random rows. Runs between steps on the calling thread and goes
+// through the step path's MoveRecord bookkeeping, so the conflict set and
+// XORs stay exact
+void PerturbConflicts(SolverContext *ctx) {
+    Board *b = ctx->board;
+    Rng *rng = &ctx->rng;
+    int numConflicts = b->numConflicts;
+    int numKicked = (numConflicts + 1) / 2;
+    int *cols = ctx->conflictCols;
+    MoveRecord *moves = ctx->moves;
+    memcpy(cols, b->conflictList, numConflicts * sizeof(int));
+
+    //Partial Shuffle: The First numKicked Entries Are A Random Subset
+    for (int i = 0; i < numKicked; i++) {
+        int j = i + RandomBelow(rng, numConflicts - i);
+        int temp = cols[i];
+        cols[i] = cols[j];
+        cols[j] = temp;
+    }
+    for (int i = 0; i < numKicked; i++) {
+        int col = cols[i];
+        int oldRow = b->queens[col];
+        int newRow = RandomBelow(rng, b->n);
+        moves[i].fromRow = -1;
+        moves[i].crossed = 0;
+        if (newRow != oldRow) {
+            moves[i].fromRow = oldRow;
+            moves[i].crossed = UpdateQueen(b, col, newRow);
+        }
+    }
+    RefreshConflicts(b, cols, moves, numKicked);
+    if (atomic_load(&b->saturated) && !WidenCounters(b)) {
+        ctx->outOfMemory = 1;
+    }
+}
+
+// Throw the board away and place it again, keeping every allocation (but
+// the counters, if they were widened since the start)
+static void RestartSearch(SolverContext *ctx) {
+    if (!ResetBoard(ctx->board, ctx->board->n) || !PlaceQueens(ctx, ctx->init)) {
+        ctx->outOfMemory = 1;
+    }
+}
+
+// With a deadline, copy the board whenever it has fewer conflicts than any
+// before it in this solve. Without one this is a single comparison
+static void TrackBest(SolverContext *ctx) {
+    Board *b = ctx->board;
+    if (ctx->deadline <= 0 || b->numConflicts >= ctx->bestConflicts) {
+        return;
+    }
+    if (b->n > ctx->bestCapacity) {
+        free(ctx->bestQueens);
+        ctx->bestQueens = (int *)malloc((size_t)b->n * sizeof(int));
+        ctx->bestCapacity = b->n;
+        if (ctx->bestQueens == NULL) {
+            ctx->bestCapacity = 0;
+            ctx->outOfMemory = 1;
+            return;
+        }
+    }
+    memcpy(ctx->bestQueens, b->queens, (size_t)b->n * sizeof(int));
+    ctx->bestConflicts = b->numConflicts;
+}
+
+// Put the board TrackBest kept back in place if it beats the current one,
+// recounting its lines and conflict set
+static void RestoreBest(SolverContext *ctx) {
+    Board *b = ctx->board;
+    if (ctx->deadline <= 0 || ctx->outOfMemory || ctx->bestConflicts >= b->numConflicts) {
+        return;
+    }
+    int n = b->n;
+    if (!ResetBoard(b, n)) {
+        ctx->outOfMemory = 1;
+        return;
+    }
+    memcpy(b->queens, ctx->bestQueens, (size_t)n * sizeof(int));
+    CountQueens(b);
+    for (int col = 0; col < n; col++) {
+        int row = b->queens[col];
+        b->rowXor[row] ^= col + 1;
+        b->diag1Xor[row - col + n] ^= col + 1;
+        b->diag2Xor[row + col] ^= col + 1;
+    }
+    if (!FinishPlacement(b)) {
+        ctx->outOfMemory = 1;
+    }
+}
+
+// Shared state of one ValidateSolutionParallel call
+typedef struct {
+    const int *queens;
+    int n;
+    int numWorkers;
+    size_t words; // Words per worker bitmap, rows then both diagonals
+    WorkerScratch *workers;
+    atomic_int ok;
+} ValidateData;
+
+// Pool task: claim the lines of one contiguous block of columns in the
+// worker's private bitmap
+static void ValidateClaimTask(void *arg, int worker) {
+    ValidateData *v = (ValidateData *)arg;
+    uint64_t *bits = v->workers[worker].lineBits;
+    memset(bits, 0, v->words * sizeof(uint64_t));
+    int from = (int)((long)v->n * worker / v->numWorkers);
+    int to = (int)((long)v->n * (worker + 1) / v->numWorkers);
+    uint64_t *diag1 = bits + RowWords(v->n);
+    uint64_t *diag2 = diag1 + DiagWords(v->n);
+    if (!ClaimLines(v->queens, from, to, v->n, bits, diag1, diag2)) {
+        atomic_store(&v->ok, 0);
+    }
+}
+
+// Pool task: merge one slice of words across all worker bitmaps, failing if
+// two workers claimed the same line
+static void ValidateMergeTask(void *arg, int worker) {
+    ValidateData *v = (ValidateData *)arg;
+    size_t from = v->words * worker / v->numWorkers;
+    size_t to = v->words * (worker + 1) / v->numWorkers;
+    for (size_t i = from; i < to; i++) {
+        uint64_t seen = 0;
+        for (int w = 0; w < v->numWorkers; w++) {
+            uint64_t bits = v->workers[w].lineBits[i];
+            if (seen & bits) {
+                atomic_store(&v->ok, 0);
+                return;
+            }
+            seen |= bits;
+        }
+    }
+}
+
+// O(n) validation spread over the context's pool, using the per-worker
+// bitmaps reserved by PrepareSolverContext for this n
+static int ValidateSolutionParallel(SolverContext *ctx, int *queens, int n) {
+    ValidateData v;
+    v.queens = queens;
+    v.n = n;
+    v.numWorkers = ctx->pool->numWorkers;
+    v.words = RowWords(n) + 2 * DiagWords(n);
+    v.workers = ctx->workers;
+    atomic_store(&v.ok, 1);
+    RunWorkerPool(ctx->pool, ValidateClaimTask, &v);
+    if (atomic_load(&v.ok) && v.numWorkers > 1) {
+        RunWorkerPool(ctx->pool, ValidateMergeTask, &v);
+    }
+    return atomic_load(&v.ok);
+}
+
+#ifdef NQ_TELEMETRY
+// Open one hardware counter of the calling thread, in group (or leading a
+// new group when group is -1), counting user space only
+static int OpenPerfCounter(uint64_t config, int group) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.disabled = group == -1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group, 0);
+}
+
+// Close whichever of the worker's counters are open
+static void ClosePerf(Telemetry *tm) {
+    for (int k = 0; k < 3; k++) {
+        if (tm->perfFds[k] >= 0) {close(tm->perfFds[k]);}
+        tm->perfFds[k] = -1;
+    }
+}
+
+// Current cycles, LLC misses and branch misses of ws's counter group
+static void ReadPerf(Telemetry *tm, uint64_t out[3]) {
+    uint64_t buf[4] = {0, 0, 0, 0};
+    if (read(tm->perfFds[0], buf, sizeof(buf)) < (ssize_t)sizeof(uint64_t)) {
+        buf[0] = 0;
+    }
+    for (int k = 0; k < 3; k++) {
+        out[k] = k < (int)buf[0] ? buf[k + 1] : 0;
+    }
+}
+
+// Start timing a step task on this worker's thread. The perf group is
+// opened on first use from the thread that will keep running this worker,
+// since the pool never moves a worker between threads
+static void TelemetryBegin(WorkerScratch *ws, int perf) {
+    Telemetry *tm = &ws->tm;
+    if (perf && tm->perfState == 0) {
+        static const uint64_t events[3] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_CACHE_MISSES,
+                                           PERF_COUNT_HW_BRANCH_MISSES};
+        tm->perfState = 1;
+        for (int k = 0; k < 3; k++) {
+            tm->perfFds[k] = tm->perfState == 1 ? OpenPerfCounter(events[k], k ? tm->perfFds[0] : -1) : -1;
+            if (tm->perfFds[k] < 0) {tm->perfState = -1;}
+        }
+        if (tm->perfState == 1) {
+            ioctl(tm->perfFds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        } else {
+            ClosePerf(tm);
+        }
+    }
+    if (perf && tm->perfState == 1) {
+        ReadPerf(tm, tm->perfStart);
+    }
+    tm->taskStart = NowSeconds();
+}
+
+static void TelemetryEnd(WorkerScratch *ws, int perf) {
+    Telemetry *tm = &ws->tm;
+    tm->busy += NowSeconds() - tm->taskStart;
+    if (perf && tm->perfState == 1) {
+        uint64_t now[3];
+        ReadPerf(tm, now);
+        for (int k = 0; k < 3; k++) {
+            tm->perf[k] += now[k] - tm->perfStart[k];
+        }
+    }
+}
+#define TELEMETRY_BEGIN(data, worker) TelemetryBegin(&(data)->workers[worker], (data)->ctx->tracePerf)
+#define TELEMETRY_END(data, worker) TelemetryEnd(&(data)->workers[worker], (data)->ctx->tracePerf)
+#else
+#define TELEMETRY_BEGIN(data, worker) ((void)0)
+#define TELEMETRY_END(data, worker) ((void)0)
+#endif
+
+// Free the context (the pool belongs to the caller)
+static void DeleteSolverContext(SolverContext *ctx) {
+    if (ctx == NULL){return;}
+    for (int w = 0; w < ctx->pool->numWorkers; w++) {
+        ArenaFree(&ctx->workers[w].arena);
+#ifdef NQ_TELEMETRY
+        if (ctx->workers[w].tm.perfState == 1) {ClosePerf(&ctx->workers[w].tm);}
+#endif
+    }
+    free(ctx->workers);
+    free(ctx->conflictCols);
+    free(ctx->moves);
+    free(ctx->queued);
+    free(ctx->bestQueens);
+    free(ctx->chunkStart);
+    CloseCheckpoint(ctx);
+    DeleteBoard(ctx->board);
+    free(ctx);
+}
+
+// Columns a worker handles between looks at StopRequested, so a deadline is
+// kept even while a single step over a huge board runs
+#define STOP_CHECK_COLS 256
+
+// Mark columns a stopped worker never reached as not moved
+static void SkipColumns(MoveRecord *moves, int numCols) {
+    for (int i = 0; i < numCols; i++) {
+        moves[i].fromRow = -1;
+        moves[i].crossed = 0;
+    }
+}
+
+// Range of the step's columns a worker handles, empty past the last one
+static inline void StepChunk(const StepData *data, int worker, int *start, int *end) {
+    if (data->chunkStart != NULL) {
+        *start = data->chunkStart[worker];
+        *end = data->chunkStart[worker + 1];
+        return;
+    }
+    *end = (worker + 1) * data->chunkSize;
+    if (*end > data->numCols) {
+        *end = data->numCols;
+    }
+    *start = worker * data->chunkSize;
+    if (*start > *end) {
+        *start = *end;
+    }
+}
+
+// Pool task: each worker minimizes conflicts for its chunk of the step, in
+// blocks of STOP_CHECK_COLS
+static void MinimizeConflictsTask(void *arg, int worker) {
+    StepData *data = (StepData *)arg;
+    int start, end;
+    StepChunk(data, worker, &start, &end);
+    TELEMETRY_BEGIN(data, worker);
+    for (int from = start; from < end; from += STOP_CHECK_COLS) {
+        int count = end - from < STOP_CHECK_COLS ? end - from : STOP_CHECK_COLS;
+        if (from > start && StopRequested(data->ctx)) {
+            SkipColumns(&data->moves[from], end - from);
+            break;
+        }
+        MinimizeConflicts(data->board, &data->cols[from], &data->moves[from], count, &data->workers[worker]);
+    }
+    TELEMETRY_END(data, worker);
+}
+
+// Pool task for bulk mode: minimize the chunk against the step's snapshot,
+// then bucket its deltas. Workers without columns still clear their groups
+static void MinimizeSnapshotTask(void *arg, int worker) {
+    StepData *data = (StepData *)arg;
+    int start, end;
+    StepChunk(data, worker, &start, &end);
+    WorkerScratch *ws = &data->workers[worker];
+    TELEMETRY_BEGIN(data, worker);
+    for (int from = start; from < end; from += STOP_CHECK_COLS) {
+        int count = end - from < STOP_CHECK_COLS ? end - from : STOP_CHECK_COLS;
+        if (from > start && StopRequested(data->ctx)) {
+            SkipColumns(&data->moves[from], end - from);
+            break;
+        }
+        MinimizeConflictsSnapshot(data->board, &data->cols[from], &data->moves[from], count, ws, data->salt);
+    }
+    BucketDeltas(data->board, &data->cols[start], &data->moves[start], end - start, ws, data->numWorkers);
+    ClearOwnLines(data->board, &data->cols[start], &data->moves[start], end - start, ws);
+    TELEMETRY_END(data, worker);
+}
+
+// Pool task for bulk mode: apply every worker's group of deltas for the
+// lines this worker owns
+static void MergeDeltasTask(void *arg, int worker) {
+    StepData *data = (StepData *)arg;
+    TELEMETRY_BEGIN(data, worker);
+    for (int w = 0; w < data->numWorkers; w++) {
+        WorkerScratch *ws = &data->workers[w];
+        int from = worker ? ws->deltaEnd[worker - 1] : 0;
+        int to = ws->deltaEnd[worker];
+        for (int i = from; i < to; i++) {
+            ApplyDelta(data->board, ws->deltas[i]);
+        }
+    }
+    TELEMETRY_END(data, worker);
+}
+
+// Shared state of one round of the asynchronous engine. A round ends when
+// the board looks solved, when no worker can find a queued column, when the
+// visit budget runs out or when a counter saturates; the caller then settles
+// the conflict set exactly and starts another round if needed
+typedef struct {
+    Board *board;
+    WorkerScratch *workers;
+    atomic_uchar *queued;
+    int numWorkers;
+    long baseExcess;    // Excess when the round started
+    long maxVisits;     // Budget for the whole solve, all workers together
+    atomic_long visits; // Columns visited so far, flushed in batches
+    atomic_int idle;    // Workers that found no column anywhere
+    atomic_int done;
+    const SolverContext *ctx; // Checked for StopRequested with every flush
+} AsyncData;
+
+// Columns a worker visits between flushes of its count to AsyncData.visits
+#define ASYNC_VISIT_BATCH 64
+
+// Board columns per active worker. On small boards every worker would be
+// moving queens the others are looking at, so the extra workers sit out
+#define ASYNC_COLUMNS_PER_WORKER 256
+
+// Queens beyond the first on every line, summed; zero iff no conflicts
+static long CountExcess(Board *b) {
+    long excess = 0;
+    for (int i = 0; i < b->n; i++) {
+        int c = GetCounter(b, b->rowConflicts, i);
+        excess += c > 1 ? c - 1 : 0;
+    }
+    for (int i = 0; i < 2 * b->n; i++) {
+        int c1 = GetCounter(b, b->diag1Conflicts, i);
+        int c2 = GetCounter(b, b->diag2Conflicts, i);
+        excess += (c1 > 1 ? c1 - 1 : 0) + (c2 > 1 ? c2 - 1 : 0);
+    }
+    return excess;
+}
+
+// Current excess: the round's base plus every worker's running change. Only
+// a hint while moves are in flight, exact once the round is over
+static long AsyncExcess(AsyncData *a) {
+    long excess = a->baseExcess;
+    for (int w = 0; w < a->numWorkers; w++) {
+        excess += atomic_load_explicit(&a->workers[w].excess, memory_order_relaxed);
+    }
+    return excess;
+}
+
+// Put col on d unless some worker already owns it: queued[col] is set from
+// the enqueue until its visitor has moved the queen and released it, so no
+// two workers ever move the same queen at once
+static inline void EnqueueColumn(AsyncData *a, Deque *d, int col) {
+    if (col < 0 || col >= a->board->n) {
+        return;
+    }
+    if (atomic_exchange_explicit(&a->queued[col], 1, memory_order_acq_rel)) {
+        return;
+    }
+    PushDeque(d, col);
+}
+
+// Next column for worker: its own deque first, then one sweep of steals
+// from the others starting at a random victim
+static int NextColumn(AsyncData *a, int worker, Rng *rng) {
+    int col;
+    do {
+        col = StealDeque(&a->workers[worker].deque);
+    } while (col == DEQUE_ABORT);
+    if (col >= 0 || a->numWorkers == 1) {
+        return col;
+    }
+    int start = RandomBelow(rng, a->numWorkers);
+    for (int i = 0; i < a->numWorkers; i++) {
+        int victim = (start + i) % a->numWorkers;
+        if (victim == worker) {continue;}
+        do {
+            col = StealDeque(&a->workers[victim].deque);
+        } while (col == DEQUE_ABORT);
+        if (col >= 0) {
+            return col;
+        }
+    }
+    return DEQUE_EMPTY;
+}
+
+// Pool task for async mode: visit conflicted columns until the round ends
+static void AsyncSearchTask(void *arg, int worker) {
+    AsyncData *a = (AsyncData *)arg;
+    if (worker >= a->numWorkers) {
+        return;
+    }
+    Board *b = a->board;
+    WorkerScratch *ws = &a->workers[worker];
+    int n = b->n;
+    int *xors[3] = {b->rowXor, b->diag1Xor, b->diag2Xor};
+    long excess = 0;
+    int visits = 0;
+    int isIdle = 0;
+
+    while (!atomic_load_explicit(&a->done, memory_order_relaxed)) {
+        int col = NextColumn(a, worker, &ws->rng);
+
+        //Nothing Queued Anywhere: Finish If Solved Or If Everyone Is Idle
+        if (col < 0) {
+            if (!isIdle) {
+                isIdle = 1;
+                atomic_fetch_add(&a->idle, 1);
+            }
+            if (AsyncExcess(a) == 0 || atomic_load(&a->idle) == a->numWorkers) {
+                atomic_store(&a->done, 1);
+            } else {
+                sched_yield();
+            }
+            continue;
+        }
+        if (isIdle) {
+            isIdle = 0;
+            atomic_fetch_sub(&a->idle, 1);
+        }
+
+        //Flush The Visit Count Now And Then, Stopping Once Over Budget
+        if (++visits == ASYNC_VISIT_BATCH) {
+            if (atomic_fetch_add(&a->visits, visits) + visits >= a->maxVisits ||
+                StopRequested(a->ctx)) {
+                atomic_store(&a->done, 1);
+            }
+            visits = 0;
+        }
+
+        int newRow = ChooseRow(b, col, ws);
+        if (newRow < 0 || newRow == b->queens[col]) {
+            atomic_store_explicit(&a->queued[col], 0, memory_order_release);
+            continue;
+        }
+        int crossed = UpdateQueenAsync(b, col, newRow, &excess);
+        atomic_store_explicit(&ws->excess, excess, memory_order_relaxed);
+
+        // A lone queen on a line this move joined is now conflicted. The
+        // line XOR names it, unless a racing move garbles the guess; a
+        // queen missed that way is picked up when the round is settled
+        long lines[3] = {newRow, newRow - col + n, newRow + col};
+        for (int k = 0; k < 3; k++) {
+            if (crossed & (CROSS_NEW_ROW << k)) {
+                int guess = (atomic_load_explicit((atomic_int *)&xors[k][lines[k]], memory_order_relaxed) ^ (col + 1)) - 1;
+                if (guess >= 0 && guess < n && HasConflict(b, guess)) {
+                    EnqueueColumn(a, &ws->deque, guess);
+                }
+            }
+        }
+
+        //Release The Column, Then Claim It Again If It Is Still Conflicted
+        atomic_store_explicit(&a->queued[col], 0, memory_order_release);
+        if (HasConflict(b, col)) {
+            EnqueueColumn(a, &ws->deque, col);
+        }
+        if (atomic_load_explicit(&b->saturated, memory_order_relaxed)) {
+            atomic_store(&a->done, 1);
+        }
+    }
+    atomic_fetch_add(&a->visits, visits);
+}
+
+// Pool task: queue the conflicted columns of one block that no deque holds.
+// Run when a round has drained every deque with conflicts left, which a
+// queen that chose to stay put or a garbled XOR guess leaves behind
+static void AsyncRescanTask(void *arg, int worker) {
+    AsyncData *a = (AsyncData *)arg;
+    if (worker >= a->numWorkers) {
+        return;
+    }
+    Board *b = a->board;
+    Deque *d = &a->workers[worker].deque;
+    int to = BlockStart(b->n, a->numWorkers, worker + 1);
+    for (int col = BlockStart(b->n, a->numWorkers, worker); col < to; col++) {
+        if (HasConflict(b, col)) {
+            EnqueueColumn(a, d, col);
+        }
+    }
+}
+
+// Run the asynchronous engine on ctx's prepared board until it is solved or
+// maxSteps * n column visits, all workers together, are spent. Returns the
+// columns visited
+static long SearchAsync(SolverContext *ctx, int maxSteps) {
+    Board *board = ctx->board;
+    int numWorkers = ctx->pool->numWorkers;
+    if (numWorkers > board->n / ASYNC_COLUMNS_PER_WORKER) {
+        numWorkers = board->n / ASYNC_COLUMNS_PER_WORKER > 1 ? board->n / ASYNC_COLUMNS_PER_WORKER : 1;
+    }
+    AsyncData a;
+    a.board = board;
+    a.workers = ctx->workers;
+    a.queued = ctx->queued;
+    a.numWorkers = numWorkers;
+    a.maxVisits = (long)maxSteps * board->n;
+    a.ctx = ctx;
+    atomic_store(&a.visits, 0);
+
+    //Deal The Placed Board's Conflict Set Out In Random Order
+    int numConflicts = board->numConflicts;
+    int *cols = ctx->conflictCols;
+    memcpy(cols, board->conflictList, numConflicts * sizeof(int));
+    memset(ctx->queued, 0, board->n * sizeof(atomic_uchar));
+    for (int w = 0; w < numWorkers; w++) {
+        WorkerScratch *ws = &ctx->workers[w];
+        ResetDeque(&ws->deque, ws->deque.buf, ws->deque.mask);
+        atomic_store(&ws->excess, 0);
+    }
+    for (int i = numConflicts - 1; i > 0; i--) {
+        int j = RandomBelow(&ctx->rng, i + 1);
+        int temp = cols[i];
+        cols[i] = cols[j];
+        cols[j] = temp;
+    }
+    for (int i = 0; i < numConflicts; i++) {
+        EnqueueColumn(&a, &ctx->workers[i % numWorkers].deque, cols[i]);
+    }
+    a.baseExcess = CountExcess(board);
+
+    int drained = 0;
+    while (a.baseExcess > 0 && atomic_load(&a.visits) < a.maxVisits && !ctx->outOfMemory &&
+           !StopRequested(ctx)) {
+        if (drained) {
+            RunWorkerPool(ctx->pool, AsyncRescanTask, &a);
+        }
+        atomic_store(&a.idle, 0);
+        atomic_store(&a.done, 0);
+
+        RunWorkerPool(ctx->pool, AsyncSearchTask, &a);
+
+        // Settle the round from what the workers kept: with no move in
+        // flight their excess changes are exact, and the columns still
+        // queued carry over. Only saturated counters need a full recount
+        if (atomic_load(&board->saturated)) {
+            if (!WidenCounters(board)) {
+                ctx->outOfMemory = 1;
+                break;
+            }
+            a.baseExcess = CountExcess(board);
+        } else {
+            a.baseExcess = AsyncExcess(&a);
+        }
+        for (int w = 0; w < numWorkers; w++) {
+            atomic_store(&ctx->workers[w].excess, 0);
+        }
+        drained = atomic_load(&a.idle) == numWorkers;
+    }
+
+    //The Conflict Set Is Only Needed Again Once The Search Is Over
+    if (a.baseExcess == 0) {
+        board->numConflicts = 0;
+    } else if (!ctx->outOfMemory) {
+        RebuildConflictSet(board);
+    }
+    TrackBest(ctx);
+    return atomic_load(&a.visits);
+}
+
+
+
+
+
+// Row of column col's queen in the classic explicit solution for n != 2, 3:
+// even rows then odd rows (1-based), with the n mod 6 == 2 and n mod 6 == 3
+// cases patched as in Hoffman, Loessi and Moore (1969). Returns a 0-based row
+static inline int ConstructRow(int n, int col) {
+    int evens = n / 2;
+    int odds = n - evens;
+    int row;
+    if (col < evens) {
+        //2, 4, 6, ... With 2 Moved To The End When n mod 6 == 3
+        if (n % 6 == 3) {
+            row = col == evens - 1 ? 2 : 2 * (col + 2);
+        } else {
+            row = 2 * (col + 1);
+        }
+    } else {
+        //1, 3, 5, ... Reordered When n mod 6 Is 2 Or 3
+        int k = col - evens;
+        if (n % 6 == 2) {
+            row = k == 0 ? 3 : k == 1 ? 1 : k == odds - 1 ? 5 : 2 * (k + 1) + 1;
+        } else if (n % 6 == 3) {
+            row = k == odds - 2 ? 1 : k == odds - 1 ? 3 : 2 * (k + 2) + 1;
+        } else {
+            row = 2 * k + 1;
+        }
+    }
+    return row - 1;
+}
+
+// Board symmetries applied to a constructed solution, as flag bits
+#define SYMMETRY_FLIP_COLS  0x1
+#define SYMMETRY_FLIP_ROWS  0x2
+#define SYMMETRY_TRANSPOSE  0x4
+
+// Shared state of one ConstructSolution call
+typedef struct {
+    int *queens;
+    int n;
+    int numWorkers;
+    int symmetry;
+} ConstructData;
+
+// Pool task: write one contiguous block of columns. A transposed board is
+// the inverse permutation, scattered by row, which is still race free
+static void ConstructTask(void *arg, int worker) {
+    ConstructData *c = (ConstructData *)arg;
+    int n = c->n;
+    int from = BlockStart(n, c->numWorkers, worker);
+    int to = BlockStart(n, c->numWorkers, worker + 1);
+    for (int col = from; col < to; col++) {
+        int row = ConstructRow(n, (c->symmetry & SYMMETRY_FLIP_COLS) ? n - 1 - col : col);
+        if (c->symmetry & SYMMETRY_FLIP_ROWS) {
+            row = n - 1 - row;
+        }
+        if (c->symmetry & SYMMETRY_TRANSPOSE) {
+            c->queens[row] = col;
+        } else {
+            c->queens[col] = row;
+        }
+    }
+}
+
+// Write a solution for n straight into the board's queens across the pool,
+// under one of the eight board symmetries picked by symmetry. Returns 0 for
+// n = 2 and 3, which have none
+static int ConstructSolution(SolverContext *ctx, int n, int symmetry) {
+    if (n == 2 || n == 3) {
+        return 0;
+    }
+    ConstructData c;
+    c.queens = ctx->board->queens;
+    c.n = n;
+    c.numWorkers = ctx->pool->numWorkers;
+    c.symmetry = symmetry;
+    RunWorkerPool(ctx->pool, ConstructTask, &c);
+    return 1;
+}
+
+// Change in total diagonal excess (queens beyond the first per diagonal) if
+// the queens of columns i and j swapped rows. The eight touched diagonals can
+// coincide, so equal lines are merged before their counts are looked at
+static int SwapDelta(Board *b, int i, int j) {
+    int n = b->n;
+    int ri = b->queens[i], rj = b->queens[j];
+    long lines[2][4] = {{ri - i + n, rj - i + n, rj - j + n, ri - j + n},
+                        {ri + i, rj + i, rj + j, ri + j}};
+    CounterArray counters[2] = {b->diag1Conflicts, b->diag2Conflicts};
+    static const int change[4] = {-1, 1, -1, 1};
+    int delta = 0;
+    for (int k = 0; k < 2; k++) {
+        for (int a = 0; a < 4; a++) {
+            //Count Each Distinct Line Once, At Its First Occurrence
+            int seen = 0, d = change[a];
+            for (int c = 0; c < a; c++) {
+                seen |= lines[k][c] == lines[k][a];
+            }
+            if (seen) {continue;}
+            for (int c = a + 1; c < 4; c++) {
+                if (lines[k][c] == lines[k][a]) {d += change[c];}
+            }
+            if (d == 0) {continue;}
+            int before = GetCounter(b, counters[k], lines[k][a]);
+            int after = before + d;
+            delta += (after > 1 ? after - 1 : 0) - (before > 1 ? before - 1 : 0);
+        }
+    }
+    return delta;
+}
+
+// Swap the rows of the queens in columns i and j and bring the conflict set
+// up to date. Only queens alone on a touched diagonal before or after the
+// swap can change status, and the diagonal XORs name those
+static void ApplySwap(Board *b, int i, int j) {
+    int n = b->n;
+    int ri = b->queens[i], rj = b->queens[j];
+    long d1[4] = {ri - i + n, rj - j + n, rj - i + n, ri - j + n};
+    long d2[4] = {ri + i, rj + j, rj + i, ri + j};
+    int candidates[16];
+    int numCandidates = 0;
+
+    //Lone Queens Before The Swap May Be About To Gain A Neighbour
+    for (int k = 0; k < 4; k++) {
+        if (GetCounter(b, b->diag1Conflicts, d1[k]) == 1) {candidates[numCandidates++] = b->diag1Xor[d1[k]] - 1;}
+        if (GetCounter(b, b->diag2Conflicts, d2[k]) == 1) {candidates[numCandidates++] = b->diag2Xor[d2[k]] - 1;}
+    }
+
+    UpdateQueen(b, i, rj);
+    UpdateQueen(b, j, ri);
+    b->rowXor[ri] ^= (i + 1) ^ (j + 1);
+    b->rowXor[rj] ^= (i + 1) ^ (j + 1);
+    for (int k = 0; k < 2; k++) {
+        int col = k == 0 ? i : j;
+        b->diag1Xor[d1[k]] ^= col + 1;
+        b->diag2Xor[d2[k]] ^= col + 1;
+        b->diag1Xor[d1[k + 2]] ^= col + 1;
+        b->diag2Xor[d2[k + 2]] ^= col + 1;
+    }
+
+    //Lone Queens After The Swap May Have Just Lost Theirs
+    for (int k = 0; k < 4; k++) {
+        if (GetCounter(b, b->diag1Conflicts, d1[k]) == 1) {candidates[numCandidates++] = b->diag1Xor[d1[k]] - 1;}
+        if (GetCounter(b, b->diag2Conflicts, d2[k]) == 1) {candidates[numCandidates++] = b->diag2Xor[d2[k]] - 1;}
+    }
+    for (int k = 0; k < numCandidates; k++) {
+        RecheckConflict(b, candidates[k]);
+    }
+    RecheckConflict(b, i);
+    RecheckConflict(b, j);
+}
+
+// Permutation swap search in the style of Sosic and Gu's QS: queens stay a
+// permutation and a conflicted queen swaps rows with a random column
+// whenever that does not raise the diagonal excess. Taking the sideways
+// swaps too keeps small boards from sticking in a local minimum. Runs on
+// the calling thread, gives up after maxSteps * n attempts and returns the
+// swaps made
+static long SearchSwaps(SolverContext *ctx, int maxSteps) {
+    Board *b = ctx->board;
+    Rng *rng = &ctx->rng;
+    int n = b->n;
+    long maxAttempts = (long)maxSteps * n;
+    long swaps = 0;
+    for (long attempt = 0; attempt < maxAttempts && b->numConflicts > 0; attempt++) {
+        if ((attempt & 4095) == 0) {
+            TrackBest(ctx);
+            if (ctx->progress && (attempt >> 12) % ctx->progressEvery == 0) {
+                ctx->progress(ctx->progressArg, (int)(swaps < INT_MAX ? swaps : INT_MAX), b->numConflicts,
+                              NowSeconds() - ctx->solveStart);
+            }
+            if (StopRequested(ctx)) {
+                break;
+            }
+        }
+        int i = b->conflictList[RandomBelow(rng, b->numConflicts)];
+        int j = RandomBelow(rng, n);
+        if (i == j || SwapDelta(b, i, j) > 0) {
+            continue;
+        }
+        ApplySwap(b, i, j);
+        swaps++;
+        if (atomic_load_explicit(&b->saturated, memory_order_relaxed) && !WidenCounters(b)) {
+            ctx->outOfMemory = 1;
+            break;
+        }
+    }
+    return swaps;
+}
+
+
+
+// Auto split depth: fix rows until there are this many tasks per worker
+#define COUNT_TASKS_PER_WORKER 64
+
+// Partial placement of the first rows, counted to completion by one worker
+typedef struct {
+    uint64_t cols;   // Columns taken
+    uint64_t left;   // Diagonals blocked on the next row, moving left
+    uint64_t right;  // ... and moving right
+    uint64_t weight; // 2 for a first-row queen left of centre (mirror), else 1
+} CountPrefix;
+
+// Shared state of one CountSolutions call
+typedef struct {
+    CountPrefix *tasks;
+    long numTasks;
+    int rowsLeft;               // Rows still empty in every task
+    uint64_t all;               // The n column bits
+    atomic_long next;           // Next task to hand out
+    atomic_ullong solutions;
+    atomic_ullong nodes;
+} CountData;
+
+// Count the ways to fill rowsLeft more rows below a partial placement, with
+// an explicit stack of the open candidates per row. The last row is counted
+// with a popcount rather than visited. Adds the queens placed to *nodes
+static uint64_t CountCompletions(uint64_t all, uint64_t cols, uint64_t left, uint64_t right,
+                                 int rowsLeft, uint64_t *nodes) {
+    if (rowsLeft == 0) {
+        return 1;
+    }
+    uint64_t colStack[COUNT_MAX_N], leftStack[COUNT_MAX_N], rightStack[COUNT_MAX_N], openStack[COUNT_MAX_N];
+    uint64_t count = 0, placed = 0;
+    uint64_t open = all & ~(cols | left | right);
+    int depth = 0;
+    for (;;) {
+        if (depth == rowsLeft - 1) {
+            //Last Row: Every Open Square Is A Solution
+            int fits = __builtin_popcountll(open);
+            count += fits;
+            placed += fits;
+            open = 0;
+        }
+        if (open == 0) {
+            if (depth == 0) {break;}
+            depth--;
+            cols = colStack[depth];
+            left = leftStack[depth];
+            right = rightStack[depth];
+            open = openStack[depth];
+            continue;
+        }
+        uint64_t bit = open & -open;
+        open ^= bit;
+        placed++;
+        colStack[depth] = cols;
+        leftStack[depth] = left;
+        rightStack[depth] = right;
+        openStack[depth] = open;
+        depth++;
+        cols |= bit;
+        left = (left | bit) << 1;
+        right = (right | bit) >> 1;
+        open = all & ~(cols | left | right);
+    }
+    *nodes += placed;
+    return count;
+}
+
+// Append every placement of the next depth rows below a partial one to the
+// task list, which grows as needed. Queens placed on the way go to *nodes
+static void SplitTasks(CountPrefix **tasks, long *numTasks, long *capacity, uint64_t all,
+                       uint64_t cols, uint64_t left, uint64_t right, uint64_t weight, int depth, uint64_t *nodes) {
+    if (depth == 0) {
+        if (*numTasks == *capacity) {
+            *capacity = *capacity ? 2 * *capacity : 1024;
+            *tasks = (CountPrefix *)realloc(*tasks, *capacity * sizeof(CountPrefix));
+        }
+        (*tasks)[(*numTasks)++] = (CountPrefix){cols, left, right, weight};
+        return;
+    }
+    for (uint64_t open = all & ~(cols | left | right); open; open &= open - 1) {
+        uint64_t bit = open & -open;
+        (*nodes)++;
+        SplitTasks(tasks, numTasks, capacity, all, cols | bit, (left | bit) << 1, (right | bit) >> 1,
+                   weight, depth - 1, nodes);
+    }
+}
+
+// Pool task: take tasks off the shared list until it runs dry
+static void CountPrefixesTask(void *arg, int worker) {
+    (void)worker;
+    CountData *c = (CountData *)arg;
+    uint64_t solutions = 0, nodes = 0;
+    long t;
+    while ((t = atomic_fetch_add_explicit(&c->next, 1, memory_order_relaxed)) < c->numTasks) {
+        CountPrefix *task = &c->tasks[t];
+        solutions += task->weight * CountCompletions(c->all, task->cols, task->left, task->right, c->rowsLeft, &nodes);
+    }
+    atomic_fetch_add(&c->solutions, solutions);
+    atomic_fetch_add(&c->nodes, nodes);
+}
+
+// Count every solution for n by bitmask backtracking. A board and its mirror
+// image are both counted from the left half of the first row; on odd n the
+// centre column is searched once. The first ctx->splitDepth rows are fixed
+// serially and the resulting prefixes are dealt to the pool; 0 deepens the
+// split until there are enough of them to keep every worker busy
+static SolveResult CountSolutions(SolverContext *ctx, int n, uint64_t seed) {
+    SolveResult result;
+    memset(&result, 0, sizeof(result));
+    result.seed = seed;
+    if (n > COUNT_MAX_N) {
+        result.status = SOLVE_UNSUPPORTED;
+        return result;
+    }
+    double start = NowSeconds();
+    int numWorkers = ctx->pool->numWorkers;
+    uint64_t all = (1ULL << n) - 1;
+
+    //Fix The First Rows Serially, Deepening Until There Is Enough Work
+    CountPrefix *tasks = NULL;
+    long numTasks = 0, capacity = 0;
+    uint64_t splitNodes = 0;
+    int depth = ctx->splitDepth ? ctx->splitDepth : 2;
+    if (depth > n) {
+        depth = n;
+    }
+    for (;;) {
+        numTasks = 0;
+        splitNodes = 0;
+        for (int col = 0; col < (n + 1) / 2; col++) {
+            uint64_t bit = 1ULL << col;
+            uint64_t weight = (n % 2 == 1 && col == n / 2) ? 1 : 2;
+            splitNodes++;
+            SplitTasks(&tasks, &numTasks, &capacity, all, bit, bit << 1, bit >> 1, weight, depth - 1, &splitNodes);
+        }
+        if (ctx->splitDepth || depth == n || numTasks >= (long)COUNT_TASKS_PER_WORKER * numWorkers) {
+            break;
+        }
+        depth++;
+    }
+    double split = NowSeconds();
+
+    //Count The Rest On The Pool
+    CountData c;
+    c.tasks = tasks;
+    c.numTasks = numTasks;
+    c.rowsLeft = n - depth;
+    c.all = all;
+    atomic_store(&c.next, 0);
+    atomic_store(&c.solutions, 0);
+    atomic_store(&c.nodes, 0);
+    RunWorkerPool(ctx->pool, CountPrefixesTask, &c);
+    double end = NowSeconds();
+    free(tasks);
+
+    result.status = SOLVE_SOLVED;
+    result.solutions = atomic_load(&c.solutions);
+    result.nodes = splitNodes + atomic_load(&c.nodes);
+    result.steps = numTasks;
+    result.initTime = split - start;
+    result.loopTime = end - split;
+    return result;
+}
+
+// Shuffle cols[0, count) to randomize processing order
+static void ShuffleColumns(Rng *rng, int *cols, int count) {
+    for (int i = count - 1; i > 0; i--) {
+        int j = RandomBelow(rng, i + 1);
+        int temp = cols[i];
+        cols[i] = cols[j];
+        cols[j] = temp;
+    }
+}
+
+// Steps between moves of the locality blocks' boundaries
+#define LOCALITY_ROTATE_STEPS 16
+
+// Locality mode: lay the step's conflicted columns out by column block, the
+// block ClearBoardTask gave worker k going to worker k, each block shuffled
+// on its own. Every LOCALITY_ROTATE_STEPS steps the boundaries move by a
+// random shift of up to a quarter block, so columns near a boundary do not
+// always meet the same neighbours while most stay with their worker
+static void GroupConflicts(SolverContext *ctx, int step, int *cols) {
+    Board *b = ctx->board;
+    int n = b->n, numConflicts = b->numConflicts;
+    int numWorkers = ctx->pool->numWorkers;
+    int *start = ctx->chunkStart;
+    int *next = &ctx->chunkStart[numWorkers + 1];
+
+    if (step % LOCALITY_ROTATE_STEPS == 0) {
+        ctx->localityShift = RandomBelow(&ctx->rng, n / numWorkers / 4 + 1);
+    }
+    int shift = ctx->localityShift;
+
+    //Count Each Block's Columns, Then Place Them After The Blocks Before It
+    memset(start, 0, (numWorkers + 1) * sizeof(int));
+    for (int i = 0; i < numConflicts; i++) {
+        int col = b->conflictList[i];
+        start[BlockOf(n, numWorkers, col >= shift ? col - shift : col - shift + n) + 1]++;
+    }
+    for (int k = 0; k < numWorkers; k++) {
+        start[k + 1] += start[k];
+        next[k] = start[k];
+    }
+    for (int i = 0; i < numConflicts; i++) {
+        int col = b->conflictList[i];
+        cols[next[BlockOf(n, numWorkers, col >= shift ? col - shift : col - shift + n)]++] = col;
+    }
+    for (int k = 0; k < numWorkers; k++) {
+        ShuffleColumns(&ctx->rng, &cols[start[k]], start[k + 1] - start[k]);
+    }
+}
+
+#ifdef NQ_TELEMETRY
+// Zero every worker's counters
+static void ZeroTelemetry(SolverContext *ctx) {
+    for (int w = 0; w < ctx->pool->numWorkers; w++) {
+        Telemetry *tm = &ctx->workers[w].tm;
+        tm->scans = tm->ties = tm->moves = tm->noops = 0;
+        tm->busy = 0;
+        memset(tm->perf, 0, sizeof(tm->perf));
+    }
+}
+
+// Start a run's totals; the workers' counters are zeroed too, since the
+// swap and async engines feed them without ever being traced
+static void TraceReset(SolverContext *ctx, SolveTelemetry *totals) {
+    memset(totals, 0, sizeof(*totals));
+    ZeroTelemetry(ctx);
+}
+
+// Gather and zero the workers' counters for the step just taken, add them
+// to the run's totals and write the step's trace line
+static void TraceStep(SolverContext *ctx, int run, int step, int numConflicts, double elapsed,
+                      double serial, double parallel, SolveTelemetry *totals) {
+    long moves = 0, noops = 0, scans = 0, ties = 0;
+    double busyMin = 0, busyMax = 0, busySum = 0;
+    uint64_t perf[3] = {0, 0, 0};
+    for (int w = 0; w < ctx->pool->numWorkers; w++) {
+        Telemetry *tm = &ctx->workers[w].tm;
+        moves += tm->moves;
+        noops += tm->noops;
+        scans += tm->scans;
+        ties += tm->ties;
+        busyMin = w == 0 || tm->busy < busyMin ? tm->busy : busyMin;
+        busyMax = tm->busy > busyMax ? tm->busy : busyMax;
+        busySum += tm->busy;
+        for (int k = 0; k < 3; k++) {
+            perf[k] += tm->perf[k];
+        }
+    }
+    ZeroTelemetry(ctx);
+    totals->moves += moves;
+    totals->noops += noops;
+    totals->scans += scans;
+    totals->ties += ties;
+    totals->serial += serial;
+    totals->parallel += parallel;
+    totals->busy += busySum;
+    if (ctx->trace != NULL) {
+        fprintf(ctx->trace, "%d,%d,%d,%.9f,%d,%ld,%ld,%ld,%ld,%.9f,%.9f,%.9f,%.9f,%.9f,%llu,%llu,%llu\n",
+                ctx->board->n, run, step, elapsed, numConflicts, moves, noops, scans, ties, serial, parallel,
+                busyMin, busyMax, busySum,
+                (unsigned long long)perf[0], (unsigned long long)perf[1], (unsigned long long)perf[2]);
+    }
+}
+
+// The run's totals plus what the swap and async engines left in the
+// workers' counters
+static SolveTelemetry TraceTotals(const SolverContext *ctx, const SolveTelemetry *totals) {
+    SolveTelemetry t = *totals;
+    for (int w = 0; w < ctx->pool->numWorkers; w++) {
+        const Telemetry *tm = &ctx->workers[w].tm;
+        t.moves += tm->moves;
+        t.noops += tm->noops;
+        t.scans += tm->scans;
+        t.ties += tm->ties;
+    }
+    t.workers = ctx->pool->numWorkers;
+    return t;
+}
+#define TELEMETRY_STAMP(t) double t = NowSeconds()
+#define TELEMETRY_TOTALS(totals) SolveTelemetry totals; TraceReset(ctx, &totals)
+#define TELEMETRY_STEP(...) TraceStep(__VA_ARGS__)
+#define TELEMETRY_SUMMARY(totals) result.telemetry = TraceTotals(ctx, &totals)
+#else
+#define TELEMETRY_STAMP(t) ((void)0)
+#define TELEMETRY_TOTALS(totals) ((void)0)
+#define TELEMETRY_STEP(...) ((void)0)
+#define TELEMETRY_SUMMARY(totals) ((void)0)
+#endif
+
+// Solve the N-Queens problem using an optimized parallel Min-Conflicts
+// algorithm. Every random draw of the run comes from streams split off seed
+static SolveResult SolveParallel(SolverContext *ctx, int n, int maxSteps, uint64_t seed) {
+
+    //Counting Has No Board To Solve
+    if (ctx->engine == ENGINE_COUNT) {
+        return CountSolutions(ctx, n, seed);
+    }
+
+    //Store REAL time counts
+    SolveResult result;
+    memset(&result, 0, sizeof(result));
+    result.seed = seed;
+    double start = NowSeconds();
+    ctx->solveStart = start;
+    ctx->stopAt = ctx->deadline > 0 ? start + ctx->deadline : 0;
+    ctx->bestConflicts = INT_MAX;
+    ctx->outOfMemory = 0;
+
+    //Reset Board And Buffers Left From The Previous Run, Or Resume A Checkpoint
+    int resumed = PrepareSolverContext(ctx, n, seed);
+    if (resumed < 0) {
+        result.status = resumed == PREPARE_NO_MEMORY ? SOLVE_NO_MEMORY : SOLVE_CHECKPOINT_FAILED;
+        return result;
+    }
+    Board *board = ctx->board;
+    int numCPU = ctx->pool->numWorkers;
+    Rng *mainRng = &ctx->rng;
+    Checkpoint *cp = &ctx->checkpoint;
+    if (resumed) {
+        result.resumed = 1;
+        result.seed = cp->header->seed;
+    }
+
+    //Setup Step State
+    int step = resumed ? cp->header->step : 0;
+    int *conflictCols = ctx->conflictCols;
+    MoveRecord *moves = ctx->moves;
+    StepData stepData;
+    stepData.board = board;
+    stepData.cols = conflictCols;
+    stepData.moves = moves;
+    stepData.workers = ctx->workers;
+    stepData.numWorkers = numCPU;
+    stepData.ctx = ctx;
+    stepData.chunkStart = NULL;
+    int bulk = ctx->stepMode == STEP_BULK && n <= BULK_MAX_N;
+
+    int swap = ctx->engine == ENGINE_SWAP;
+    int construct = ctx->engine == ENGINE_CONSTRUCT;
+    TELEMETRY_TOTALS(totals);
+#ifdef NQ_TELEMETRY
+    ctx->traceRun++;
+#endif
+
+    double loopStart = NowSeconds();
+    result.initTime = loopStart - start;
+
+    //Swap And Asynchronous Searches Have No Steps; They Come Back Solved Or
+    //Out Of Budget, Counting Swaps Or Column Visits Instead
+    int async = !swap && ctx->stepMode == STEP_ASYNC;
+    long work = 0;
+    if (swap || async) {
+        work = swap ? SearchSwaps(ctx, maxSteps) : SearchAsync(ctx, maxSteps);
+        step = board->numConflicts == 0 ? 0 : maxSteps;
+    }
+
+    //Or No Search At All, With A Random Symmetry Unless Asked For The Plain One
+    if (construct) {
+        int symmetry = ctx->constructSymmetry ? (int)(NextRng(mainRng) & 7) : 0;
+        if (!ConstructSolution(ctx, n, symmetry)) {
+            result.status = SOLVE_NO_SOLUTION;
+            result.loopTime = NowSeconds() - loopStart;
+            return result;
+        }
+    }
+
+    //Stagnation Tracking Against The Fewest Conflicts Seen
+    int bestConflicts = INT_MAX;
+    int sinceBest = 0;
+    int stalls = 0;
+
+    //While Within Valid Step
+    while (step < maxSteps && !ctx->outOfMemory) {
+
+        int numConflicts = board->numConflicts;
+
+        //If Solved
+        if (numConflicts == 0) {
+
+            //Stop The Clock
+            double loopEnd = NowSeconds();
+
+            //In A Portfolio Only The First Member To Finish Validates
+            result.loopTime = loopEnd - loopStart;
+            if (ctx->cancel != NULL && atomic_exchange(ctx->cancel, 1)) {
+                result.status = SOLVE_STOPPED;
+                return result;
+            }
+            result.steps = swap || async ? work : step;
+            TELEMETRY_SUMMARY(totals);
+
+            //Validate Solution, Optionally Cross-Checking The Slow Way
+            int valid = ValidateSolutionParallel(ctx, board->queens, n);
+            if (ctx->crossCheck && valid != ValidateSolutionPairwise(board->queens, n)) {
+                valid = 0;
+            }
+            result.validateTime = NowSeconds() - loopEnd;
+            result.status = valid ? SOLVE_SOLVED : SOLVE_INVALID;
+            if (cp->map != NULL) {
+                FlushCheckpoint(ctx, step);
+            }
+            return result;
+        }
+
+        //Report, Remember The Best Board, Then Stop If Told To Or Out Of Time
+        if (ctx->progress && step % ctx->progressEvery == 0) {
+            ctx->progress(ctx->progressArg, step, numConflicts, NowSeconds() - start);
+        }
+        TrackBest(ctx);
+        if (StopRequested(ctx)) {
+            break;
+        }
+
+        //Snapshot The Board Now And Then
+        if (cp->map != NULL) {
+            if (NowSeconds() >= cp->nextFlush) {
+                FlushCheckpoint(ctx, step);
+            }
+        }
+
+        //Kick A Board That Stopped Improving, Place It Again If It Keeps Stalling
+        if (numConflicts < bestConflicts) {
+            bestConflicts = numConflicts;
+            sinceBest = 0;
+            stalls = 0;
+        } else if (ctx->stallWindow > 0 && ++sinceBest >= ctx->stallWindow) {
+            sinceBest = 0;
+            if (++stalls < STALL_RESTART) {
+                PerturbConflicts(ctx);
+                result.perturbations++;
+            } else {
+                RestartSearch(ctx);
+                result.restarts++;
+                stalls = 0;
+                bestConflicts = INT_MAX;
+            }
+            step++;
+            continue;
+        }
+
+        // Take this step's columns from the conflict set and shuffle them
+        // to randomize processing order
+        TELEMETRY_STAMP(stepStart);
+        if (ctx->locality) {
+            GroupConflicts(ctx, step, conflictCols);
+            stepData.chunkStart = ctx->chunkStart;
+        } else {
+            memcpy(conflictCols, board->conflictList, numConflicts * sizeof(int));
+            ShuffleColumns(mainRng, conflictCols, numConflicts);
+        }
+
+        // Divide conflict columns among workers and run them on the pool
+        stepData.numCols = numConflicts;
+        stepData.chunkSize = (numConflicts + numCPU - 1) / numCPU;
+        TELEMETRY_STAMP(parallelStart);
+        if (bulk) {
+            stepData.salt = NextRng(mainRng);
+            RunWorkerPool(ctx->pool, MinimizeSnapshotTask, &stepData);
+            RunWorkerPool(ctx->pool, MergeDeltasTask, &stepData);
+        } else {
+            RunWorkerPool(ctx->pool, MinimizeConflictsTask, &stepData);
+        }
+        TELEMETRY_STAMP(parallelEnd);
+
+        // Fold the moves back into the conflict set, widening the counters
+        // first if one of them ran out of room during the step
+        RefreshConflicts(board, conflictCols, moves, numConflicts);
+        if (atomic_load(&board->saturated) && !WidenCounters(board)) {
+            ctx->outOfMemory = 1;
+        }
+        TELEMETRY_STAMP(stepEnd);
+        TELEMETRY_STEP(ctx, ctx->traceRun, step, numConflicts, stepEnd - start,
+                       (parallelStart - stepStart) + (stepEnd - parallelEnd), parallelEnd - parallelStart, &totals);
+
+        step++;
+    }
+    //Hand Back The Best Board Seen If It Beats Where The Search Stopped
+    RestoreBest(ctx);
+    result.status = ctx->outOfMemory ? SOLVE_NO_MEMORY : StopRequested(ctx) ? SOLVE_STOPPED : SOLVE_NOT_FOUND;
+    if (cp->map != NULL) {
+        FlushCheckpoint(ctx, step);
+    }
+    result.conflicts = board->numConflicts;
+    result.loopTime = NowSeconds() - loopStart;
+    result.steps = swap || async ? work : step;
+    TELEMETRY_SUMMARY(totals);
+    return result; // No solution found
+}
+
+
+// numMembers solver contexts racing on the same n, each with its own seed
+// and its own slice of the threads. A leader pool runs one member per
+// worker and every member drives its own pool, so the leaders plus the
+// member pools' threads add up to the thread count
+typedef struct {
+    int numMembers;
+    WorkerPool *leaders;
+    WorkerPool **pools;
+    SolverContext **members;
+    atomic_int cancel;      // Set by the first member to solve
+    int winner;             // Member whose board the last solve returned
+} Portfolio;
+
+// Shared state of one SolvePortfolio call
+typedef struct {
+    Portfolio *pf;
+    int n;
+    int maxSteps;
+    uint64_t *seeds;
+    SolveResult *results;
+} PortfolioData;
+
+static void DeletePortfolio(Portfolio *pf) {
+    if (pf == NULL) {return;}
+    for (int k = 0; pf->members != NULL && k < pf->numMembers; k++) {
+        DeleteSolverContext(pf->members[k]);
+        DeleteWorkerPool(pf->pools[k]);
+    }
+    DeleteWorkerPool(pf->leaders);
+    free(pf->members);
+    free(pf->pools);
+    free(pf);
+}
+
+// Split numThreads between numMembers members (at most one member per
+// thread). Members are configured by the caller afterwards. NULL if out
+// of memory
+static Portfolio *NewPortfolio(int numMembers, int numThreads) {
+    if (numMembers > numThreads) {
+        numMembers = numThreads;
+    }
+    Portfolio *pf = (Portfolio *)calloc(1, sizeof(Portfolio));
+    if (pf == NULL) {
+        return NULL;
+    }
+    pf->leaders = NewWorkerPool(numMembers);
+    pf->pools = (WorkerPool **)malloc(numMembers * sizeof(WorkerPool *));
+    pf->members = (SolverContext **)malloc(numMembers * sizeof(SolverContext *));
+    if (pf->leaders == NULL || pf->pools == NULL || pf->members == NULL) {
+        DeletePortfolio(pf);
+        return NULL;
+    }
+    pf->numMembers = numMembers;
+    for (int k = 0; k < numMembers; k++) {
+        pf->pools[k] = NewWorkerPool(BlockStart(numThreads, numMembers, k + 1) - BlockStart(numThreads, numMembers, k));
+        pf->members[k] = pf->pools[k] != NULL ? NewSolverContext(pf->pools[k]) : NULL;
+        if (pf->members[k] == NULL) {
+            DeleteWorkerPool(pf->pools[k]);
+            pf->numMembers = k;
+            DeletePortfolio(pf);
+            return NULL;
+        }
+        pf->members[k]->cancel = &pf->cancel;
+    }
+    return pf;
+}
+
+// Leader task: run one member's solve on its own pool
+static void PortfolioTask(void *arg, int worker) {
+    PortfolioData *d = (PortfolioData *)arg;
+    d->results[worker] = SolveParallel(d->pf->members[worker], d->n, d->maxSteps, d->seeds[worker]);
+}
+
+// Race every member on n and return the winner's result, tagged with its
+// index and seed, or member 0's if nobody solved. Its loop time is stretched
+// to the wall time of the whole race. Member 0 gets seed itself,
+// so a one-member portfolio repeats SolveParallel exactly
+static SolveResult SolvePortfolio(Portfolio *pf, int n, int maxSteps, uint64_t seed) {
+    int k = pf->numMembers;
+    uint64_t *seeds = (uint64_t *)malloc(k * sizeof(uint64_t));
+    SolveResult *results = (SolveResult *)calloc(k, sizeof(SolveResult));
+    Rng rng;
+    SeedRng(&rng, seed);
+    seeds[0] = seed;
+    for (int i = 1; i < k; i++) {
+        seeds[i] = NextRng(&rng);
+    }
+
+    PortfolioData d = {pf, n, maxSteps, seeds, results};
+    atomic_store(&pf->cancel, 0);
+    double start = NowSeconds();
+    RunWorkerPool(pf->leaders, PortfolioTask, &d);
+    double wall = NowSeconds() - start;
+
+    int winner = 0;
+    for (int i = 0; i < k; i++) {
+        if (results[i].status == SOLVE_SOLVED || results[i].status == SOLVE_INVALID) {
+            winner = i;
+            break;
+        }
+    }
+    SolveResult result = results[winner];
+    result.member = winner;
+    pf->winner = winner;
+
+    //The Loop Phase Runs Until The Losers Have Stopped Too
+    double rest = wall - result.initTime - result.validateTime - result.outputTime;
+    if (rest > result.loopTime) {
+        result.loopTime = rest;
+    }
+    free(seeds);
+    free(results);
+    return result;
+}
+
+
+
+
+// A solver is one context on its own pool, or a portfolio of them
+struct Solver {
+    SolverOptions opt;
+    int numThreads;
+    WorkerPool *pool;       // NULL for a portfolio
+    SolverContext *ctx;
+    Portfolio *portfolio;   // NULL unless opt.portfolio > 1
+    int pinned;             // Locality: workers are pinned, the caller joins callerCpu per solve
+    cpu_set_t callerCpu;
+};
+
+static pthread_once_t rowScanOnce = PTHREAD_ONCE_INIT;
+
+SolverOptions DefaultSolverOptions(void) {
+    SolverOptions opt;
+    memset(&opt, 0, sizeof(opt));
+    opt.init = INIT_RANDOM;
+    opt.engine = ENGINE_MIN_CONFLICTS;
+    opt.stepMode = STEP_ATOMIC;
+    opt.sampleMisses = 8;
+    opt.stallWindow = 64;
+    opt.constructSymmetry = 1;
+    opt.portfolio = 1;
+    opt.checkpointEvery = 60;
+    return opt;
+}
+
+// Copy the solver settings from opt into ctx
+static void ConfigureSolverContext(SolverContext *ctx, const SolverOptions *opt) {
+    ctx->init = opt->init;
+    ctx->engine = opt->engine;
+    ctx->constructSymmetry = opt->constructSymmetry;
+    ctx->splitDepth = opt->splitDepth;
+    ctx->stepMode = opt->stepMode;
+    ctx->sampleRows = opt->sampleRows;
+    ctx->sampleMisses = opt->sampleMisses;
+    ctx->stallWindow = opt->stallWindow;
+    ctx->deadline = opt->deadline;
+    ctx->stop = opt->stop;
+    ctx->progress = opt->progressEvery > 0 ? opt->progress : NULL;
+    ctx->progressArg = opt->progressArg;
+    ctx->progressEvery = opt->progressEvery;
+    ctx->checkpointPath = opt->checkpoint;
+    ctx->checkpointEvery = opt->checkpointEvery;
+    ctx->locality = opt->locality;
+#ifdef NQ_TELEMETRY
+    ctx->trace = opt->trace;
+    ctx->tracePerf = opt->tracePerf;
+#endif
+    ctx->crossCheck = opt->crossCheck;
+}
+
+// CPUs the pool's workers are pinned to, in worker order
+typedef struct {
+    int cpus[CPU_SETSIZE];
+    int numCpus;
+} PinData;
+
+// Pool task: pin a worker thread to its CPU. Worker 0 is whichever thread
+// calls Solve, so Solve pins it for the length of each solve instead
+static void PinWorkerTask(void *arg, int worker) {
+    const PinData *pin = (const PinData *)arg;
+    if (worker == 0) {
+        return;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(pin->cpus[worker % pin->numCpus], &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+// Read a cpulist file such as "0-3,8-11" into set, left empty if unreadable
+static void ReadCpuList(const char *path, cpu_set_t *set) {
+    CPU_ZERO(set);
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        return;
+    }
+    int from, to;
+    while (fscanf(f, "%d", &from) == 1) {
+        to = from;
+        int c = fgetc(f);
+        if (c == '-') {
+            if (fscanf(f, "%d", &to) != 1) {break;}
+            c = fgetc(f);
+        }
+        for (int cpu = from; cpu <= to && cpu < CPU_SETSIZE; cpu++) {
+            CPU_SET(cpu, set);
+        }
+        if (c != ',') {break;}
+    }
+    fclose(f);
+}
+
+// Append the CPUs of allowed that are also in set to pin, taking them out of allowed
+static void TakeCpus(PinData *pin, cpu_set_t *allowed, const cpu_set_t *set) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, allowed) && CPU_ISSET(cpu, set)) {
+            pin->cpus[pin->numCpus++] = cpu;
+            CPU_CLR(cpu, allowed);
+        }
+    }
+}
+
+// Pin worker k to the k-th CPU the calling thread may run on, wrapping when
+// there are more workers than CPUs. The CPUs go NUMA node by node, as
+// /sys/devices/system/node lists them, so neighbouring column blocks share
+// a node; without that directory they go in number order. Returns 0 when
+// the affinity is unknown
+static int PinWorkers(Solver *s) {
+    cpu_set_t allowed;
+    if (pthread_getaffinity_np(pthread_self(), sizeof(allowed), &allowed) != 0) {
+        return 0;
+    }
+    PinData pin;
+    pin.numCpus = 0;
+    DIR *dir = opendir("/sys/devices/system/node");
+    if (dir != NULL) {
+        int maxNode = -1, node;
+        struct dirent *entry;
+        while ((entry = readdir(dir)) != NULL) {
+            if (sscanf(entry->d_name, "node%d", &node) == 1 && node > maxNode) {
+                maxNode = node;
+            }
+        }
+        closedir(dir);
+        for (node = 0; node <= maxNode; node++) {
+            char path[64];
+            cpu_set_t set;
+            snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+            ReadCpuList(path, &set);
+            TakeCpus(&pin, &allowed, &set);
+        }
+    }
+
+    //CPUs No Node Claimed Come Last
+    cpu_set_t all;
+    memset(&all, 0xff, sizeof(all));
+    TakeCpus(&pin, &allowed, &all);
+    if (pin.numCpus == 0) {
+        return 0;
+    }
+    RunWorkerPool(s->pool, PinWorkerTask, &pin);
+    CPU_ZERO(&s->callerCpu);
+    CPU_SET(pin.cpus[0], &s->callerCpu);
+    return 1;
+}
+
+Solver *NewSolver(int numThreads, const SolverOptions *opt) {
+    pthread_once(&rowScanOnce, InitRowScan);
+    if (numThreads < 1) {
+        numThreads = 1;
+    }
+    Solver *s = (Solver *)calloc(1, sizeof(Solver));
+    if (s == NULL) {
+        return NULL;
+    }
+    s->opt = *opt;
+    s->numThreads = numThreads;
+    if (opt->portfolio > 1 && opt->engine != ENGINE_COUNT) {
+        s->portfolio = NewPortfolio(opt->portfolio, numThreads);
+        if (s->portfolio == NULL) {
+            free(s);
+            return NULL;
+        }
+        for (int k = 0; k < s->portfolio->numMembers; k++) {
+            ConfigureSolverContext(s->portfolio->members[k], opt);
+            s->portfolio->members[k]->checkpointPath = NULL;
+            s->portfolio->members[k]->locality = 0;
+        }
+    } else {
+        s->pool = NewWorkerPool(numThreads);
+        s->ctx = s->pool != NULL ? NewSolverContext(s->pool) : NULL;
+        if (s->ctx == NULL) {
+            DeleteWorkerPool(s->pool);
+            free(s);
+            return NULL;
+        }
+        ConfigureSolverContext(s->ctx, opt);
+        s->pinned = opt->locality && PinWorkers(s);
+    }
+    return s;
+}
+
+void DeleteSolver(Solver *s) {
+    if (s == NULL) {return;}
+    DeletePortfolio(s->portfolio);
+    DeleteSolverContext(s->ctx);
+    DeleteWorkerPool(s->pool);
+    free(s);
+}
+
+SolveResult Solve(Solver *s, int n, int maxSteps, uint64_t seed) {
+    if (n < 1) {
+        SolveResult result;
+        memset(&result, 0, sizeof(result));
+        result.status = SOLVE_UNSUPPORTED;
+        result.seed = seed;
+        return result;
+    }
+    if (s->portfolio) {
+        return SolvePortfolio(s->portfolio, n, maxSteps, seed);
+    }
+
+    //A Pinned Solver Holds The Caller To Worker 0's CPU, Then Lets It Go
+    cpu_set_t callerAllowed;
+    int pinCaller = s->pinned && pthread_getaffinity_np(pthread_self(), sizeof(callerAllowed), &callerAllowed) == 0;
+    if (pinCaller) {
+        pthread_setaffinity_np(pthread_self(), sizeof(s->callerCpu), &s->callerCpu);
+    }
+    SolveResult result = SolveParallel(s->ctx, n, maxSteps, seed);
+    if (pinCaller) {
+        pthread_setaffinity_np(pthread_self(), sizeof(callerAllowed), &callerAllowed);
+    }
+    return result;
+}
+
+const int *SolverQueens(const Solver *s) {
+    const SolverContext *ctx = s->portfolio ? s->portfolio->members[s->portfolio->winner] : s->ctx;
+    if (ctx->engine == ENGINE_COUNT || ctx->board == NULL) {
+        return NULL;
+    }
+    return ctx->board->queens;
+}
+
+void SolverSetDeadline(Solver *s, double seconds) {
+    s->opt.deadline = seconds;
+    if (s->portfolio) {
+        for (int k = 0; k < s->portfolio->numMembers; k++) {
+            s->portfolio->members[k]->deadline = seconds;
+        }
+    } else {
+        s->ctx->deadline = seconds;
+    }
+}
+
+int SolverThreads(const Solver *s) {return s->numThreads;}
+int SolverMembers(const Solver *s) {return s->portfolio ? s->portfolio->numMembers : 1;}
+
+const char *RowScanKernel(void) {
+    pthread_once(&rowScanOnce, InitRowScan);
+    return RowScanName;
+}
+
+uint64_t NextSeed(uint64_t *state) {
+    return SplitMix64(state);
+}
+
+#ifdef NQ_TELEMETRY
+int PerfAvailable(void) {
+    int fd = OpenPerfCounter(PERF_COUNT_HW_CPU_CYCLES, -1);
+    if (fd < 0) {
+        return 0;
+    }
+    close(fd);
+    return 1;
+}
+#endif
@@ -0,0 +1,183 @@
+#ifndef NQUEENS_H
+#define NQUEENS_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdatomic.h>
+
+// N-Queens solver library. A Solver owns its worker threads and every
+// buffer a solve needs; it is created once and reused, so solving a smaller
+// n after a larger one allocates nothing. Solvers share no state, several
+// can run side by side from different threads. Nothing here prints
+
+// How the queens are placed before the search starts
+typedef enum {
+    INIT_RANDOM,      // Any row per column, as always
+    INIT_PERMUTATION, // A random permutation, so no row conflicts
+    INIT_GREEDY       // Permutation, each queen on free diagonals when a few tries find them
+} InitMethod;
+
+// Search engine a solve runs
+typedef enum {
+    ENGINE_MIN_CONFLICTS, // Any row per column, parallel min-conflicts steps
+    ENGINE_SWAP,          // Permutation kept, rows swapped between columns
+    ENGINE_CONSTRUCT,     // No search: the closed-form solution for n
+    ENGINE_COUNT          // Exhaustive: count every solution, small n only
+} Engine;
+
+// How a step's moves reach the shared counters
+typedef enum {
+    STEP_ATOMIC, // Each move updates the counters with atomic adds at once
+    STEP_BULK,   // Moves see the step's starting counters, deltas merge at the barrier
+    STEP_ASYNC   // No steps: workers pull conflicted columns from work-stealing deques
+} StepMode;
+
+// Sample size picked per solve: SAMPLE_AUTO_ROWS rows, whatever n. While
+// more than about one row in SAMPLE_AUTO_ROWS is free a sample that size
+// finds one; once they are scarcer, longer samples would only add random
+// reads, and the miss limit backs sampling off instead. Below
+// SAMPLE_AUTO_MIN_N a vector scan is as cheap as sampling
+#define SAMPLE_AUTO -1
+#define SAMPLE_AUTO_MIN_N 4096
+#define SAMPLE_AUTO_ROWS 256
+
+// Stalls in a row, each answered by a perturbation, before the step loop
+// gives up on the board and starts over from a fresh placement
+#define STALL_RESTART 4
+
+// Largest n the count engine takes; its lines are bits of a 64-bit word
+#define COUNT_MAX_N 63
+
+// Called by the step loop every progressEvery steps (and by the swap engine
+// every few thousand attempts) with the conflicted queens left and the
+// seconds since the solve started
+typedef void (*ProgressCallback)(void *arg, int step, int numConflicts, double elapsed);
+
+// How a solve ended
+typedef enum {
+    SOLVE_SOLVED,      // Valid solution on the board (count engine: counted)
+    SOLVE_NOT_FOUND,   // Step budget spent, the board keeps its conflicts
+    SOLVE_STOPPED,     // Deadline, stop flag or another portfolio member won
+    SOLVE_INVALID,     // A finished board failed validation
+    SOLVE_NO_SOLUTION, // Construct engine: n = 2 and 3 have none
+    SOLVE_UNSUPPORTED, // Count engine: n above COUNT_MAX_N
+    SOLVE_CHECKPOINT_FAILED, // The checkpoint file could not be opened or mapped
+    SOLVE_NO_MEMORY    // The buffers for n could not be allocated, or grown mid-solve
+} SolveStatus;
+
+// Settings fixed for the lifetime of a Solver, see DefaultSolverOptions
+typedef struct {
+    InitMethod init;
+    Engine engine;
+    StepMode stepMode;
+    int sampleRows;         // Move policy: rows sampled before a full scan, 0 for none,
+                            // SAMPLE_AUTO for SAMPLE_AUTO_ROWS on large boards
+    int sampleMisses;       // Failed samples in a row before a worker backs off
+    int stallWindow;        // Steps without a new fewest conflicts before a perturbation, 0 never
+    int constructSymmetry;  // Construct engine: apply a random board symmetry
+    int splitDepth;         // Count engine: rows fixed per parallel task, 0 for auto
+    int crossCheck;         // Also run the O(n^2) validator after each solve
+    int portfolio;          // Boards racing per solve, splitting the threads, 1 for none
+    double deadline;        // Seconds a solve may take before it returns its best board, 0 for none
+    atomic_int *stop;       // Caller's flag: stop and return the current board, NULL for none
+    ProgressCallback progress; // NULL for none
+    void *progressArg;
+    int progressEvery;      // Steps between progress calls
+    const char *checkpoint; // Min-conflicts steps: file the board lives in, resumed from if it
+                            // holds the same n, NULL for none. Ignored by a portfolio
+    double checkpointEvery; // Seconds between snapshots flushed to it
+    int locality;           // Pin each worker to a CPU, NUMA node by node, give it a fixed
+                            // block of columns and let it first-touch that block's pages on
+                            // every solve. Not the checkpoint file's pages. Ignored by a portfolio
+#ifdef NQ_TELEMETRY
+    FILE *trace;            // Per-step trace lines, NULL for none
+    int tracePerf;          // Also count cycles and misses with perf_event_open
+#endif
+} SolverOptions;
+
+#ifdef NQ_TELEMETRY
+// Trace file columns: one line per min-conflicts step. Times are seconds;
+// serial is the shuffle and conflict-set refresh on the calling thread,
+// parallel the pool phase, busy_* the time workers spent inside it
+#define TRACE_HEADER "n,run,step,elapsed,conflicts,moves,noops,scans,ties,serial,parallel," \
+                     "busy_min,busy_max,busy_sum,cycles,llc_misses,branch_misses\n"
+
+// Where one solve's time and moves went, summed over its steps
+typedef struct {
+    long moves;
+    long noops;
+    long scans;
+    long ties;
+    double serial;
+    double parallel;
+    double busy;
+    int workers;    // Threads behind parallel, for the busy share
+} SolveTelemetry;
+#endif
+
+// Outcome of one solve with its wall-clock time per phase
+typedef struct {
+    SolveStatus status;
+    uint64_t seed;
+    long steps;          // Steps taken; swaps (swap engine), column visits (async
+                         // mode) or parallel tasks (count engine)
+    double initTime;     // Board reset, counters and conflict set
+    double loopTime;     // The step loop
+    double validateTime;
+    double outputTime;   // Left 0 for the caller's own output time
+    uint64_t solutions;  // Count engine: every solution for n
+    uint64_t nodes;      // Count engine: queens placed while counting
+    int member;          // Portfolio: index of the member that solved
+    int perturbations;   // Stalled boards kicked by PerturbConflicts
+    int restarts;        // ... and placed again after stalling repeatedly
+    int conflicts;       // Conflicted queens left on the board, 0 when solved
+    int resumed;         // Picked up from a checkpoint file; steps include its earlier ones
+#ifdef NQ_TELEMETRY
+    SolveTelemetry telemetry;
+#endif
+} SolveResult;
+
+typedef struct Solver Solver;
+
+// Options of a plain min-conflicts solve: random placement, atomic steps,
+// stall window 64, no deadline, no checkpoint (flushed every 60 s if set)
+SolverOptions DefaultSolverOptions(void);
+
+// Start numThreads workers (split between the members of a portfolio)
+// solving with opt, which is copied. NULL if out of memory or threads
+Solver *NewSolver(int numThreads, const SolverOptions *opt);
+void DeleteSolver(Solver *s);
+
+// Solve (or count) n queens within maxSteps steps. Every random draw comes
+// from streams split off seed, so a seed repeats its solve
+SolveResult Solve(Solver *s, int n, int maxSteps, uint64_t seed);
+
+// Queens of the last solve, queens[col] = row: the solution, or the best
+// board a stopped solve kept. Valid until the next Solve, NULL for counting.
+// With a checkpoint it points into the file's mapping
+const int *SolverQueens(const Solver *s);
+
+// Change the deadline of the solves that follow, 0 for none
+void SolverSetDeadline(Solver *s, double seconds);
+
+// Worker threads and portfolio members the solver runs
+int SolverThreads(const Solver *s);
+int SolverMembers(const Solver *s);
+
+// Row scan kernel picked for this CPU: "avx512", "avx2" or "scalar"
+const char *RowScanKernel(void);
+
+// Seeds for successive solves: splitmix64 over a caller-held state
+uint64_t NextSeed(uint64_t *state);
+
+// O(n) and O(n^2) checks that queens[0, n) hold no attacking pair. The O(n)
+// one returns -1 if it cannot allocate its line bitmaps
+int ValidateSolution(const int *queens, int n);
+int ValidateSolutionPairwise(const int *queens, int n);
+
+#ifdef NQ_TELEMETRY
+// Whether perf_event_open works here; errno says why when it does not
+int PerfAvailable(void);
+#endif
+
+#endif
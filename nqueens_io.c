@@ -0,0 +1,727 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <string.h>
+#include <limits.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "nqueens.h"
+#include "nqueens_io.h"
+#include "nqueens_time.h"
+
+// Magic at the start of OUTPUT_BINARY files
+#define BINARY_MAGIC "NQB1"
+
+// POSIX minimum is 16 but Linux and macOS both take 1024
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+// Rows of the grid handed to one writev call, three iovecs each
+#define GRID_ROWS_PER_WRITE (IOV_MAX / 3)
+
+// Bytes buffered by the text and binary writers before each write
+#define OUTPUT_BUFFER_BYTES (1 << 20)
+
+// Write all of buf, retrying short writes
+int WriteAll(int fd, const void *buf, size_t len) {
+    const char *p = (const char *)buf;
+    while (len > 0) {
+        ssize_t done = write(fd, p, len);
+        if (done <= 0) {return 0;}
+        p += done;
+        len -= done;
+    }
+    return 1;
+}
+
+// writev every iovec, retrying short writes
+static int WriteAllV(int fd, struct iovec *iov, int count) {
+    while (count > 0) {
+        ssize_t done = writev(fd, iov, count);
+        if (done < 0) {return 0;}
+        while (count > 0 && (size_t)done >= iov->iov_len) {
+            done -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0) {
+            iov->iov_base = (char *)iov->iov_base + done;
+            iov->iov_len -= done;
+        }
+    }
+    return 1;
+}
+
+// Grid writer. Every row is cut from one shared ". . . .\n" template around
+// its queens with writev, so no row is ever built byte by byte. Columns are
+// bucketed by row first so rows with several queens also come out right
+static int WriteGrid(int fd, const int *queens, int n) {
+    char *dots = (char *)malloc(2 * (size_t)n + 1);
+    int *rowStart = (int *)calloc(n + 1, sizeof(int));
+    int *colsByRow = (int *)malloc(n * sizeof(int));
+    struct iovec *iov = (struct iovec *)malloc(IOV_MAX * sizeof(struct iovec));
+    static char queenCell[] = "Q ";
+
+    for (int i = 0; i < n; i++) {
+        dots[2 * i] = '.';
+        dots[2 * i + 1] = ' ';
+    }
+    dots[2 * (size_t)n] = '\n';
+
+    //Counting Sort Of Columns By Row
+    for (int col = 0; col < n; col++) {
+        rowStart[queens[col] + 1]++;
+    }
+    for (int row = 0; row < n; row++) {
+        rowStart[row + 1] += rowStart[row];
+    }
+    int *fill = (int *)malloc(n * sizeof(int));
+    memcpy(fill, rowStart, n * sizeof(int));
+    for (int col = 0; col < n; col++) {
+        colsByRow[fill[queens[col]]++] = col;
+    }
+    free(fill);
+
+    int ok = 1;
+    int count = 0;
+    for (int row = 0; row < n && ok; row++) {
+        //Dots Up To Each Queen, The Queen, Then The Rest Of The Row
+        size_t at = 0;
+        for (int k = rowStart[row]; k < rowStart[row + 1]; k++) {
+            size_t cell = 2 * (size_t)colsByRow[k];
+            if (count + 3 > IOV_MAX) {
+                ok = WriteAllV(fd, iov, count);
+                count = 0;
+            }
+            iov[count].iov_base = dots + at;
+            iov[count++].iov_len = cell - at;
+            iov[count].iov_base = queenCell;
+            iov[count++].iov_len = 2;
+            at = cell + 2;
+        }
+        if (count + 1 > IOV_MAX) {
+            ok = WriteAllV(fd, iov, count);
+            count = 0;
+        }
+        iov[count].iov_base = dots + at;
+        iov[count++].iov_len = 2 * (size_t)n + 1 - at;
+        if (count >= GRID_ROWS_PER_WRITE * 3) {
+            ok = WriteAllV(fd, iov, count);
+            count = 0;
+        }
+    }
+    if (ok && count > 0) {
+        ok = WriteAllV(fd, iov, count);
+    }
+
+    free(dots);
+    free(rowStart);
+    free(colsByRow);
+    free(iov);
+    return ok;
+}
+
+// Permutation writer: n on the first line, then one row index per line
+static int WritePermutation(int fd, const int *queens, int n) {
+    char *buf = (char *)malloc(OUTPUT_BUFFER_BYTES);
+    size_t used = (size_t)sprintf(buf, "%d\n", n);
+    int ok = 1;
+    for (int col = 0; col < n && ok; col++) {
+        if (used + 16 > OUTPUT_BUFFER_BYTES) {
+            ok = WriteAll(fd, buf, used);
+            used = 0;
+        }
+        //Digits Backwards Into A Scratch, Then Forwards Into The Buffer
+        char digits[12];
+        int len = 0;
+        unsigned v = (unsigned)queens[col];
+        do {
+            digits[len++] = '0' + v % 10;
+            v /= 10;
+        } while (v);
+        while (len) {
+            buf[used++] = digits[--len];
+        }
+        buf[used++] = '\n';
+    }
+    if (ok) {
+        ok = WriteAll(fd, buf, used);
+    }
+    free(buf);
+    return ok;
+}
+
+// Store v little-endian at p
+static void PutLE32(unsigned char *p, uint32_t v) {
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = v >> 24;
+}
+
+// Binary writer: 8-byte header, then the rows as little-endian uint32
+static int WriteBinary(int fd, const int *queens, int n) {
+    unsigned char header[8];
+    memcpy(header, BINARY_MAGIC, 4);
+    PutLE32(header + 4, (uint32_t)n);
+    if (!WriteAll(fd, header, sizeof(header))) {
+        return 0;
+    }
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    return WriteAll(fd, queens, (size_t)n * sizeof(uint32_t));
+#else
+    unsigned char *buf = (unsigned char *)malloc(OUTPUT_BUFFER_BYTES);
+    int ok = 1;
+    size_t used = 0;
+    for (int col = 0; col < n && ok; col++) {
+        if (used + 4 > OUTPUT_BUFFER_BYTES) {
+            ok = WriteAll(fd, buf, used);
+            used = 0;
+        }
+        PutLE32(buf + used, (uint32_t)queens[col]);
+        used += 4;
+    }
+    if (ok) {
+        ok = WriteAll(fd, buf, used);
+    }
+    free(buf);
+    return ok;
+#endif
+}
+
+//Prints Solution Board Into Named file in the given format
+void PrintSolutionToFile(int *queens, int n, int run, int total, OutputFormat format){
+    static const char *suffix[] = {".txt", ".perm.txt", ".bin"};
+    char filename[100];
+    sprintf(filename, "Solution_%d_%dof%d%s",n,run,total,suffix[format]);
+
+    int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        printf(" -- ERROR: Cannot open %s\n", filename);
+        return;
+    }
+
+    int ok;
+    switch (format) {
+    case OUTPUT_PERMUTATION: ok = WritePermutation(fd, queens, n); break;
+    case OUTPUT_BINARY: ok = WriteBinary(fd, queens, n); break;
+    default: ok = WriteGrid(fd, queens, n); break;
+    }
+    if (!ok) {
+        printf(" -- ERROR: Failed writing %s\n", filename);
+    }
+    close(fd);
+}
+
+// Solutions waiting for the writer thread; each slot keeps its queens buffer
+// between runs so queueing a solution is a memcpy
+#define WRITER_SLOTS 2
+
+typedef struct {
+    int *queens;
+    int capacity;
+    int n;
+    int run;
+    int total;
+    double *seconds; // Where the write's duration goes, NULL for nowhere
+} WriterJob;
+
+// A writer is its thread plus WRITER_SLOTS solutions waiting for it
+struct SolutionWriter {
+    pthread_t thread;
+    pthread_mutex_t mu;
+    pthread_cond_t changed;
+    OutputFormat format;
+    WriterJob slots[WRITER_SLOTS];
+    int head;    // Next slot to write
+    int queued;  // Slots holding a solution
+    int shutdown;
+};
+
+// Body of the writer thread: write queued solutions in order until shutdown
+static void *SolutionWriterMain(void *arg) {
+    SolutionWriter *w = (SolutionWriter *)arg;
+    pthread_mutex_lock(&w->mu);
+    for (;;) {
+        while (w->queued == 0 && !w->shutdown) {
+            pthread_cond_wait(&w->changed, &w->mu);
+        }
+        if (w->queued == 0) {
+            break;
+        }
+        WriterJob *job = &w->slots[w->head];
+        pthread_mutex_unlock(&w->mu);
+
+        double start = NowSeconds();
+        PrintSolutionToFile(job->queens, job->n, job->run, job->total, w->format);
+        double seconds = NowSeconds() - start;
+
+        pthread_mutex_lock(&w->mu);
+        if (job->seconds != NULL) {
+            *job->seconds = seconds;
+        }
+        w->head = (w->head + 1) % WRITER_SLOTS;
+        w->queued--;
+        pthread_cond_broadcast(&w->changed);
+    }
+    pthread_mutex_unlock(&w->mu);
+    return NULL;
+}
+
+// Start a writer thread for the given format
+SolutionWriter *NewSolutionWriter(OutputFormat format) {
+    SolutionWriter *w = (SolutionWriter *)calloc(1, sizeof(SolutionWriter));
+    w->format = format;
+    pthread_mutex_init(&w->mu, NULL);
+    pthread_cond_init(&w->changed, NULL);
+    pthread_create(&w->thread, NULL, SolutionWriterMain, w);
+    return w;
+}
+
+// Copy queens into a free slot and hand it to the writer thread, waiting
+// only if every slot is still being written
+void SubmitSolution(SolutionWriter *w, const int *queens, int n, int run, int total, double *seconds) {
+    pthread_mutex_lock(&w->mu);
+    while (w->queued == WRITER_SLOTS) {
+        pthread_cond_wait(&w->changed, &w->mu);
+    }
+    WriterJob *job = &w->slots[(w->head + w->queued) % WRITER_SLOTS];
+    pthread_mutex_unlock(&w->mu);
+
+    if (n > job->capacity) {
+        free(job->queens);
+        job->queens = (int *)malloc(n * sizeof(int));
+        job->capacity = n;
+    }
+    memcpy(job->queens, queens, n * sizeof(int));
+    job->n = n;
+    job->run = run;
+    job->total = total;
+    job->seconds = seconds;
+
+    pthread_mutex_lock(&w->mu);
+    w->queued++;
+    pthread_cond_broadcast(&w->changed);
+    pthread_mutex_unlock(&w->mu);
+}
+
+// Wait until every queued solution has been written
+void FlushSolutionWriter(SolutionWriter *w) {
+    pthread_mutex_lock(&w->mu);
+    while (w->queued > 0) {
+        pthread_cond_wait(&w->changed, &w->mu);
+    }
+    pthread_mutex_unlock(&w->mu);
+}
+
+// Finish every queued write, then stop the writer thread
+void DeleteSolutionWriter(SolutionWriter *w) {
+    if (w == NULL){return;}
+    pthread_mutex_lock(&w->mu);
+    w->shutdown = 1;
+    pthread_cond_broadcast(&w->changed);
+    pthread_mutex_unlock(&w->mu);
+    pthread_join(w->thread, NULL);
+    for (int i = 0; i < WRITER_SLOTS; i++) {
+        free(w->slots[i].queens);
+    }
+    pthread_mutex_destroy(&w->mu);
+    pthread_cond_destroy(&w->changed);
+    free(w);
+}
+
+
+// Grid row kernel: checks that p[0, len) is the canonical ". Q . ." layout
+// (cells on even offsets, single spaces between) and stores the column of
+// each 'Q' in qcols, up to maxQ of them. Returns the number of queens, or
+// -1 if the row needs the general tokenizer
+typedef int (*GridRowScanFn)(const char *p, int len, int *qcols, int maxQ);
+
+// Portable grid row kernel
+static int GridRowScanScalar(const char *p, int len, int *qcols, int maxQ) {
+    int numQ = 0;
+    for (int i = 0; i < len; i++) {
+        char c = p[i];
+        if (i & 1) {
+            if (c != ' ') {return -1;}
+        } else if (c == 'Q') {
+            if (numQ < maxQ) {qcols[numQ] = i / 2;}
+            numQ++;
+        } else if (c != '.') {
+            return -1;
+        }
+    }
+    return numQ;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+// AVX2 grid row kernel: 32 bytes per compare against the ". " pattern, with
+// queens read off the 'Q' compare mask
+__attribute__((target("avx2")))
+static int GridRowScanAVX2(const char *p, int len, int *qcols, int maxQ) {
+    const __m256i pattern = _mm256_set1_epi16(0x202E); // ". " little-endian
+    const __m256i queen = _mm256_set1_epi8('Q');
+    int numQ = 0;
+    int i = 0;
+    for (; i + 32 <= len; i += 32) {
+        __m256i c = _mm256_loadu_si256((const __m256i *)&p[i]);
+        unsigned dots = _mm256_movemask_epi8(_mm256_cmpeq_epi8(c, pattern));
+        unsigned queens = _mm256_movemask_epi8(_mm256_cmpeq_epi8(c, queen)) & 0x55555555u;
+        if ((dots | queens) != 0xFFFFFFFFu) {
+            return -1;
+        }
+        while (queens) {
+            if (numQ < maxQ) {qcols[numQ] = (i + __builtin_ctz(queens)) / 2;}
+            numQ++;
+            queens &= queens - 1;
+        }
+    }
+    int tail = GridRowScanScalar(p + i, len - i, qcols + (numQ < maxQ ? numQ : maxQ),
+                                 numQ < maxQ ? maxQ - numQ : 0);
+    if (tail < 0) {
+        return -1;
+    }
+    for (int k = numQ; k < numQ + tail && k < maxQ; k++) {
+        qcols[k] += i / 2;
+    }
+    return numQ + tail;
+}
+
+#endif
+
+// Grid row kernel used by ValidateFile, chosen by InitGridRowScan
+static GridRowScanFn GridRowScan = GridRowScanScalar;
+
+// Pick the grid row kernel this CPU supports
+void InitGridRowScan(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        GridRowScan = GridRowScanAVX2;
+        return;
+    }
+#endif
+    GridRowScan = GridRowScanScalar;
+}
+
+// Parsing state of ValidateFile's grid reader
+typedef struct {
+    int n;       // Columns, -1 until the first non-empty line
+    int row;     // Rows read so far
+    int *queens; // queens[col] = row, -1 while unseen
+} GridReader;
+
+// Record the queen of the current row found at col. Returns 0 after
+// printing the error the original reader gave for a second queen
+static int PlaceGridQueen(GridReader *g, int col, int numQ) {
+    if (numQ > 1) {
+        printf("Error: More than one queen in row %d\n", g->row);
+        return 0;
+    }
+    if (g->queens[col] != -1) {
+        printf("Error: More than one queen in column %d\n", col);
+        return 0;
+    }
+    g->queens[col] = g->row;
+    return 1;
+}
+
+// Allocate the queens array once the board size is known
+static int StartGrid(GridReader *g, int n) {
+    g->n = n;
+    if (n <= 0) {
+        printf("Error: Invalid board size\n");
+        return 0;
+    }
+    g->queens = (int *)malloc(n * sizeof(int));
+    if (g->queens == NULL) {
+        printf("Error: Memory allocation failed\n");
+        return 0;
+    }
+    for (int i = 0; i < n; i++) {
+        g->queens[i] = -1;
+    }
+    return 1;
+}
+
+// General tokenizer for one grid line: cells separated by any run of spaces
+// and tabs, with exactly the checks and messages of the original reader
+static int ReadGridLineSlow(GridReader *g, const char *line, int len) {
+
+    //Count Tokens First, The First Line Sets The Board Size
+    int tokenCount = 0;
+    for (int i = 0; i < len; ) {
+        while (i < len && (line[i] == ' ' || line[i] == '\t')) {i++;}
+        if (i == len) {break;}
+        tokenCount++;
+        while (i < len && line[i] != ' ' && line[i] != '\t') {i++;}
+    }
+    if (g->n == -1) {
+        if (!StartGrid(g, tokenCount)) {return 0;}
+    } else if (tokenCount != g->n) {
+        printf("Error: Inconsistent line length at row %d\n", g->row);
+        return 0;
+    }
+
+    // Process the tokens
+    int numQ = 0; // Number of 'Q's in this row
+    int col = 0;
+    for (int i = 0; i < len; col++) {
+        while (i < len && (line[i] == ' ' || line[i] == '\t')) {i++;}
+        if (i == len) {break;}
+        int startTok = i;
+        while (i < len && line[i] != ' ' && line[i] != '\t') {i++;}
+        int tokLen = i - startTok;
+        char c = line[startTok];
+        if (tokLen != 1) {
+            printf("Error: Invalid character '%.*s' at row %d, column %d\n", tokLen, &line[startTok],
+                   g->row, col);
+            return 0;
+        }
+        if (c == 'Q') {
+            numQ++;
+            if (!PlaceGridQueen(g, col, numQ)) {return 0;}
+        } else if (c != '.') {
+            printf("Error: Invalid character '%c' at row %d, column %d\n", c, g->row, col);
+            return 0;
+        }
+    }
+
+    if (numQ == 0) {
+        printf("Error: No queen found in row %d\n", g->row);
+        return 0;
+    }
+    return 1;
+}
+
+// One grid line: canonical rows go through the vector kernel, anything
+// else (tabs, double spaces, bad characters) through the tokenizer
+static int ReadGridLine(GridReader *g, const char *line, int len) {
+
+    //Canonical Rows Are 2n-1 Bytes, Or 2n With The Writer's Trailing Space
+    int cells = len;
+    if (len > 0 && line[len - 1] == ' ' && (len & 1) == 0) {
+        cells = len - 1;
+    }
+    int canonical = (cells & 1) && (g->n == -1 || cells == 2 * g->n - 1);
+    if (canonical) {
+        int qcols[2];
+        int numQ = GridRowScan(line, cells, qcols, 2);
+        if (numQ >= 0) {
+            if (g->n == -1 && !StartGrid(g, (cells + 1) / 2)) {return 0;}
+            if (numQ == 0) {
+                printf("Error: No queen found in row %d\n", g->row);
+                return 0;
+            }
+            for (int k = 0; k < numQ && k < 2; k++) {
+                if (!PlaceGridQueen(g, qcols[k], k + 1)) {return 0;}
+            }
+            return 1;
+        }
+    }
+    return ReadGridLineSlow(g, line, len);
+}
+
+// Read an ASCII grid from data. On success *queensOut holds one row per
+// column and the board size is returned; -1 after printing an error
+static int ReadGrid(const char *data, size_t size, int **queensOut) {
+    GridReader g = {-1, 0, NULL};
+    const char *p = data, *end = data + size;
+
+    while (p < end) {
+        const char *nl = (const char *)memchr(p, '\n', end - p);
+        const char *lineEnd = nl ? nl : end;
+        const char *next = nl ? nl + 1 : end;
+
+        // Remove the line ending, \n or \r\n
+        if (lineEnd > p && lineEnd[-1] == '\r') {lineEnd--;}
+        size_t len = lineEnd - p;
+
+        // Ignore empty lines
+        if (len > 0) {
+            if (len > INT_MAX || !ReadGridLine(&g, p, (int)len)) {
+                free(g.queens);
+                return -1;
+            }
+            g.row++;
+        }
+        p = next;
+    }
+
+    int n = g.n == -1 ? 0 : g.n;
+    if (g.row != n) {
+        printf("Error: Expected %d rows, but got %d rows\n", n, g.row);
+        free(g.queens);
+        return -1;
+    }
+
+    // Now check if all columns have a queen
+    for (int col = 0; col < n; col++) {
+        if (g.queens[col] == -1) {
+            printf("Error: No queen found in column %d\n", col);
+            free(g.queens);
+            return -1;
+        }
+    }
+    *queensOut = g.queens;
+    return n;
+}
+
+// Read an OUTPUT_PERMUTATION file: n, then n row numbers
+static int ReadPermutation(const char *data, size_t size, int **queensOut) {
+    const char *p = data, *end = data + size;
+    long n = -1;
+    int *queens = NULL;
+    int count = 0;
+
+    while (p < end) {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) {p++;}
+        if (p == end) {break;}
+        const char *tok = p;
+        long v = 0;
+        while (p < end && *p >= '0' && *p <= '9' && v <= INT_MAX) {
+            v = v * 10 + (*p++ - '0');
+        }
+        if (p == tok || v > INT_MAX || (p < end && *p != ' ' && *p != '\t' && *p != '\n' && *p != '\r')) {
+            const char *bad = tok;
+            while (p < end && *p != ' ' && *p != '\t' && *p != '\n' && *p != '\r') {p++;}
+            printf("Error: Invalid value '%.*s' at column %d\n", (int)(p - bad), bad, count);
+            free(queens);
+            return -1;
+        }
+        if (n == -1) {
+            n = v;
+            if (n <= 0) {
+                printf("Error: Invalid board size\n");
+                return -1;
+            }
+            queens = (int *)malloc(n * sizeof(int));
+            if (queens == NULL) {
+                printf("Error: Memory allocation failed\n");
+                return -1;
+            }
+        } else if (count == n) {
+            printf("Error: Expected %ld queens, but got more\n", n);
+            free(queens);
+            return -1;
+        } else {
+            queens[count++] = (int)v;
+        }
+    }
+
+    if (n == -1 || count != n) {
+        printf("Error: Expected %ld queens, but got %d queens\n", n < 0 ? 0 : n, count);
+        free(queens);
+        return -1;
+    }
+    *queensOut = queens;
+    return (int)n;
+}
+
+// Read an OUTPUT_BINARY file
+static int ReadBinary(const char *data, size_t size, int **queensOut) {
+    const unsigned char *u = (const unsigned char *)data;
+    uint32_t n = u[4] | (u[5] << 8) | (u[6] << 16) | ((uint32_t)u[7] << 24);
+    if (n == 0 || n > INT_MAX) {
+        printf("Error: Invalid board size\n");
+        return -1;
+    }
+    if (size != 8 + (size_t)n * 4) {
+        printf("Error: Expected %u queens, but got %zu bytes of rows\n", n, size - 8);
+        return -1;
+    }
+    int *queens = (int *)malloc((size_t)n * sizeof(int));
+    if (queens == NULL) {
+        printf("Error: Memory allocation failed\n");
+        return -1;
+    }
+    for (uint32_t col = 0; col < n; col++) {
+        const unsigned char *q = u + 8 + 4 * (size_t)col;
+        uint32_t row = q[0] | (q[1] << 8) | (q[2] << 16) | ((uint32_t)q[3] << 24);
+        queens[col] = row > INT_MAX ? -1 : (int)row;
+    }
+    *queensOut = queens;
+    return (int)n;
+}
+
+// Validate the solution stored in path. The file is memory-mapped and read
+// in one pass; it may be an ASCII grid of any size, an OUTPUT_PERMUTATION
+// or an OUTPUT_BINARY file. Returns 1 for a valid solution, 0 otherwise
+int ValidateFile(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        printf("Error: Cannot open %s\n", path);
+        return 0;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        printf("Error: Cannot open %s\n", path);
+        close(fd);
+        return 0;
+    }
+
+    size_t size = (size_t)st.st_size;
+    const char *data = "";
+    if (size > 0) {
+        void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            printf("Error: Cannot open %s\n", path);
+            close(fd);
+            return 0;
+        }
+        madvise(map, size, MADV_SEQUENTIAL);
+        data = (const char *)map;
+    }
+    close(fd);
+
+    //Pick The Format From The First Bytes
+    int *queens = NULL;
+    int n;
+    const char *first = data;
+    while (first < data + size && (*first == ' ' || *first == '\t' || *first == '\n' || *first == '\r')) {
+        first++;
+    }
+    if (size >= 8 && memcmp(data, BINARY_MAGIC, 4) == 0) {
+        n = ReadBinary(data, size, &queens);
+    } else if (first < data + size && *first >= '0' && *first <= '9') {
+        n = ReadPermutation(data, size, &queens);
+    } else {
+        n = ReadGrid(data, size, &queens);
+    }
+    if (size > 0) {
+        munmap((void *)data, size);
+    }
+    if (n < 0) {
+        return 0;
+    }
+
+    // Now we have queens[col] = row for each column.
+    // Now validate the solution
+    int valid = ValidateSolution(queens, n);
+    if (valid < 0) {
+        printf("Error: Memory allocation failed\n");
+        valid = 0;
+    } else if (valid) {
+        printf("Valid solution\n");
+    } else {
+        printf("Invalid solution\n");
+    }
+    free(queens);
+    return valid;
+}
+
+// File input function that validates input.txt as a solution for nQueens, and
+// validates it Required function for assignment submission
+void file_input(void) {
+  ValidateFile("input.txt");
+}
@@ -0,0 +1,50 @@
+#ifndef NQUEENS_IO_H
+#define NQUEENS_IO_H
+
+#include <stddef.h>
+
+// Solution files: the writers behind --print and the reader behind --check.
+// Both sides know the same three formats
+
+// Ways a solution can be written out
+typedef enum {
+    OUTPUT_GRID,        // n x n ASCII board, "Q " and ". " cells, as always
+    OUTPUT_PERMUTATION, // Text: n, then the row of each column's queen
+    OUTPUT_BINARY       // "NQB1", uint32 n, then n uint32 rows, little-endian
+} OutputFormat;
+
+// Write all of buf to fd, retrying short writes. 0 on an error
+int WriteAll(int fd, const void *buf, size_t len);
+
+// Write queens to Solution_<n>_<run>of<total> with the format's suffix
+void PrintSolutionToFile(int *queens, int n, int run, int total, OutputFormat format);
+
+// Writes solutions on a background thread so the next run starts while the
+// previous one is still going to disk
+typedef struct SolutionWriter SolutionWriter;
+
+// Start a writer thread for the given format
+SolutionWriter *NewSolutionWriter(OutputFormat format);
+
+// Copy queens into a free slot and hand it to the writer thread, waiting
+// only if every slot is still being written. The seconds the write took go
+// to *seconds, if not NULL, once it is done; read them after a flush
+void SubmitSolution(SolutionWriter *w, const int *queens, int n, int run, int total, double *seconds);
+
+// Wait until every queued solution has been written
+void FlushSolutionWriter(SolutionWriter *w);
+
+// Finish every queued write, then stop the writer thread
+void DeleteSolutionWriter(SolutionWriter *w);
+
+// Pick the grid row kernel this CPU supports; call once before ValidateFile
+void InitGridRowScan(void);
+
+// Validate the solution stored in path, in any of the three formats, and
+// print the verdict. Returns 1 for a valid solution, 0 otherwise
+int ValidateFile(const char *path);
+
+// Validate input.txt, as the assignment asks
+void file_input(void);
+
+#endif